@@ -0,0 +1,21 @@
+#! /bin/bash
+
+# two stage profile guided optimization build, output in ./build/pgo
+set -e
+
+# stage 1: instrumented build
+rm -rf ./build/pgo/pgo-profile
+cmake --preset pgo-generate "$@"
+cmake --build --preset pgo-generate
+
+# record the profile by running the benchmark workloads
+ctest --preset pgo-train
+
+# clang writes raw profiles that need merging
+if ls ./build/pgo/pgo-profile/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -output=./build/pgo/pgo-profile/default.profdata ./build/pgo/pgo-profile/*.profraw
+fi
+
+# stage 2: rebuild with the profile
+cmake --preset pgo-use "$@"
+cmake --build --preset pgo-use
@@ -0,0 +1,71 @@
+/// @file fuzz/format_fuzzer.cpp
+
+#include "fuzz_input.hpp"
+#include "reference.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief PrettyPrinter against the iostream reference and the policy properties
+ *
+ * Input: precision, width buffer, max width and scientific threshold bytes,
+ * then doubles. Each double is formatted, every 3 are printed as a Vec3 and
+ * every 9 as a Mat33.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput input(data, size);
+
+    // negative precisions too, iostream prints 6 decimal places for them
+    ReferenceSettings settings;
+    settings.precision = int(input.byte() % 40) - 4;
+    settings.widthBuffer = input.byte() % 8;
+    settings.policy.maxWidth = 1 + input.byte() % 63;
+    const uint8_t threshold = input.byte();
+    settings.policy.sciThreshold = threshold == 0xFF ? HUGE_VAL : pow(10.0, threshold % 40);
+
+    vector<double> values;
+    while (input.remainingValues() > 0)
+    {
+        values.push_back(input.value());
+    }
+
+    ostringstream out;
+    PrettyPrinter printer;
+    configurePrinter(printer, settings, out);
+    auto format = [&](double value) { return printer.format(value); };
+    for (double value : values)
+    {
+        const string formatted = printer.format(value);
+        const string failure = checkFormat(value, formatted, settings);
+        FUZZ_CHECK(failure.empty(), "format(%a), precision %d, max width %d: \"%s\", %s",
+                   value, settings.precision, settings.policy.maxWidth, formatted.c_str(), failure.c_str());
+    }
+
+    for (size_t i=0; i + 3 <= values.size(); i += 3)
+    {
+        const Vec3 vec = {values[i], values[i + 1], values[i + 2]};
+        out.str("");
+        printer.print(vec);
+        const string expected = referencePrint(vec, settings.widthBuffer, format);
+        FUZZ_CHECK(expected == out.str(), "print(Vec3) from value %zu:\n%s\nexpected:\n%s",
+                   i, out.str().c_str(), expected.c_str());
+    }
+
+    for (size_t i=0; i + 9 <= values.size(); i += 9)
+    {
+        Mat33 mat;
+        copy(&values[i], &values[i + 9], &mat.col[0].x);
+        out.str("");
+        printer.print(mat);
+        const string expected = referencePrint(mat, settings.widthBuffer, format);
+        FUZZ_CHECK(expected == out.str(), "print(Mat33) from value %zu:\n%s\nexpected:\n%s",
+                   i, out.str().c_str(), expected.c_str());
+    }
+    return 0;
+}
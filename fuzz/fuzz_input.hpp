@@ -0,0 +1,73 @@
+/// @file fuzz/fuzz_input.hpp
+
+#ifndef SARCOS_FUZZ_INPUT_H
+#define SARCOS_FUZZ_INPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * @brief Reads the bytes of a fuzz input as settings and doubles
+ *
+ * Reads past the end give zeros, so every input is valid.
+ */
+class FuzzInput
+{
+public:
+    FuzzInput(const uint8_t* data, size_t size)
+    : m_data(data)
+    , m_size(size)
+    {}
+
+    /// next byte
+    uint8_t byte()
+    {
+        if (m_size == 0)
+        {
+            return 0;
+        }
+        m_size--;
+        return *m_data++;
+    }
+
+    /// next 8 bytes as a double in host byte order
+    double value()
+    {
+        uint8_t bytes[sizeof(double)] = {};
+        for (uint8_t& b : bytes)
+        {
+            b = byte();
+        }
+        double value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    /// number of whole doubles left
+    size_t remainingValues() const { return m_size / sizeof(double); }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+};
+
+/**
+ * @brief report a difference with the reference and abort, so the fuzzer keeps the input
+ *
+ */
+#define FUZZ_CHECK(condition, ...)                                          \
+    do                                                                      \
+    {                                                                       \
+        if (!(condition))                                                   \
+        {                                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__);                                   \
+            fprintf(stderr, "\n");                                          \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+#endif // SARCOS_FUZZ_INPUT_H
@@ -0,0 +1,88 @@
+/// @file fuzz/math_fuzzer.cpp
+
+#include "fuzz_input.hpp"
+#include "reference.hpp"
+#include "sarcos/math_kernels.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief SIMD math kernels against the scalar functions of math.hpp
+ *
+ * Input: doubles, 18 per record: two vectors (6 values, the rest of the
+ * first matrix) and two matrices. Every SIMD level supported by the host
+ * must give the scalar results bit for bit.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput input(data, size);
+    const size_t count = input.remainingValues() / 18;
+
+    vector<Vec3> vecs1(count), vecs2(count);
+    vector<Mat33> mats1(count), mats2(count);
+    for (size_t i=0; i<count; i++)
+    {
+        double* first = &mats1[i].col[0].x;
+        double* second = &mats2[i].col[0].x;
+        for (int k=0; k<9; k++)
+        {
+            first[k] = input.value();
+        }
+        for (int k=0; k<9; k++)
+        {
+            second[k] = input.value();
+        }
+        vecs1[i] = mats1[i].col[0];
+        vecs2[i] = mats1[i].col[1];
+    }
+
+    vector<double> dots(count);
+    vector<Mat33> results(count);
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        if (level > detectSimdLevel())
+        {
+            break;
+        }
+        const MathKernels& kernels = mathKernels(level);
+        const char* name = simdLevelName(level);
+
+        kernels.dotProducts(vecs1.data(), vecs2.data(), dots.data(), count);
+        for (size_t i=0; i<count; i++)
+        {
+            FUZZ_CHECK(sameResult(dotProduct(vecs1[i], vecs2[i]), dots[i]), "%s dotProducts, record %zu", name, i);
+        }
+
+        results = mats1;
+        kernels.transposeMats(results.data(), count);
+        for (size_t i=0; i<count; i++)
+        {
+            Mat33 expected = mats1[i];
+            transposeMat(expected);
+            FUZZ_CHECK(sameResult(expected, results[i]), "%s transposeMats, record %zu", name, i);
+        }
+
+        kernels.copyMats(mats2.data(), results.data(), count);
+        for (size_t i=0; i<count; i++)
+        {
+            FUZZ_CHECK(sameResult(copyMat(mats2[i]), results[i]), "%s copyMats, record %zu", name, i);
+        }
+
+        kernels.multiplyMats(mats1.data(), mats2.data(), results.data(), count);
+        for (size_t i=0; i<count; i++)
+        {
+            FUZZ_CHECK(sameResult(multiplyMat(mats1[i], mats2[i]), results[i]), "%s multiplyMats, record %zu", name, i);
+        }
+
+        // results aliasing the second operand
+        results = mats2;
+        kernels.multiplyMats(mats1.data(), results.data(), results.data(), count);
+        for (size_t i=0; i<count; i++)
+        {
+            FUZZ_CHECK(sameResult(multiplyMat(mats1[i], mats2[i]), results[i]), "%s multiplyMats in place, record %zu", name, i);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+/// @file fuzz/replay_main.cpp
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace
+{
+    /**
+     * @brief corpus files: the path itself, or the files of a directory
+     *
+     */
+    void collectFiles(const string& path, vector<string>& files)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            cerr << "cannot open " << path << "\n";
+            exit(1);
+        }
+        if (!S_ISDIR(info.st_mode))
+        {
+            files.push_back(path);
+            return;
+        }
+
+        DIR* dir = opendir(path.c_str());
+        while (dirent* entry = dir ? readdir(dir) : nullptr)
+        {
+            if (entry->d_name[0] != '.')
+            {
+                collectFiles(path + "/" + entry->d_name, files);
+            }
+        }
+        if (dir)
+        {
+            closedir(dir);
+        }
+    }
+
+    /**
+     * @brief value of a -name=value argument
+     *
+     */
+    bool flagValue(const char* arg, const char* name, unsigned long& value)
+    {
+        const size_t len = strlen(name);
+        if (strncmp(arg, name, len) != 0 || arg[len] != '=')
+        {
+            return false;
+        }
+        value = strtoul(arg + len + 1, nullptr, 10);
+        return true;
+    }
+}
+
+/**
+ * @brief Runs a fuzz target without libFuzzer, for compilers that do not provide it
+ *
+ * Usage: <target> [-runs=N] [-seed=S] [-max_len=L] [corpus file or directory...]
+ *
+ * Replays every corpus file, then N random inputs of up to L bytes. Same flags
+ * as libFuzzer, so the commands work with both builds.
+ */
+int main(int argc, char** argv)
+{
+    unsigned long runs = 0, seed = 1, maxLen = 4096;
+    vector<string> files;
+    for (int i=1; i<argc; i++)
+    {
+        if (flagValue(argv[i], "-runs", runs) || flagValue(argv[i], "-seed", seed) || flagValue(argv[i], "-max_len", maxLen))
+        {
+            continue;
+        }
+        if (argv[i][0] == '-')
+        {
+            // other libFuzzer flags do not apply to a replay
+            continue;
+        }
+        collectFiles(argv[i], files);
+    }
+
+    for (const string& file : files)
+    {
+        ifstream in(file, ios::binary);
+        vector<uint8_t> data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+
+    mt19937_64 rng(seed);
+    vector<uint8_t> data;
+    for (unsigned long run=0; run<runs; run++)
+    {
+        data.resize(uniform_int_distribution<size_t>(0, maxLen)(rng));
+        for (uint8_t& byte : data)
+        {
+            byte = uint8_t(rng());
+        }
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+
+    cout << "replayed " << files.size() << " corpus inputs and " << runs << " random inputs\n";
+    return 0;
+}
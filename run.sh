@@ -1,4 +1,7 @@
 #! /bin/bash
 
-# run the executable
-./build/sarcos_quiz
\ No newline at end of file
+# run the executable, the demonstration by default
+if [ $# -eq 0 ]; then
+    set -- --demo
+fi
+./build/sarcos_quiz "$@"
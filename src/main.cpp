@@ -1,16 +1,19 @@
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "sarcos/batch.hpp"
 #include "sarcos/math.hpp"
 #include "sarcos/prettyprinter.hpp"
 
 using namespace std;
 
 /**
- * @brief main entry function
+ * @brief demonstration of the requested functionality
  * 
- * @return int 
  */
-int main()
+static void runDemo()
 {
     PrettyPrinter printer;
 
@@ -137,6 +140,96 @@ int main()
     node2 = nullptr;
     delete node1;
     node1 = nullptr;
+}
 
+/**
+ * @brief main entry function
+ * 
+ * Runs a batch over the records of a file or standard input, see printUsage().
+ * 
+ * @return int - 0 on success, 1 on a failed run, 2 on invalid arguments
+ */
+int main(int argc, char** argv)
+{
+    BatchOptions options;
+    string error;
+    if (!parseBatchOptions(argc, argv, options, error))
+    {
+        cerr << "sarcos_quiz: " << error << "\n\n";
+        printUsage(cerr);
+        return 2;
+    }
+    if (options.help)
+    {
+        printUsage(cout);
+        return 0;
+    }
+    if (options.demo)
+    {
+        runDemo();
+        return 0;
+    }
+
+    // buffers outlive the streams using them
+    vector<char> inBuffer(options.ioBufferSize), outBuffer(options.ioBufferSize);
+
+    istream* in = &cin;
+    ifstream inFile;
+    if (options.inputPath != "-")
+    {
+        if (!inBuffer.empty())
+        {
+            inFile.rdbuf()->pubsetbuf(inBuffer.data(), inBuffer.size());
+        }
+        inFile.open(options.inputPath, ios::binary);
+        if (!inFile)
+        {
+            cerr << "sarcos_quiz: cannot open " << options.inputPath << "\n";
+            return 1;
+        }
+        in = &inFile;
+    }
+
+    ostream* out = &cout;
+    ofstream outFile;
+    if (options.outputPath != "-")
+    {
+        if (!outBuffer.empty())
+        {
+            outFile.rdbuf()->pubsetbuf(outBuffer.data(), outBuffer.size());
+        }
+        outFile.open(options.outputPath, ios::binary);
+        if (!outFile)
+        {
+            cerr << "sarcos_quiz: cannot open " << options.outputPath << "\n";
+            return 1;
+        }
+        out = &outFile;
+    }
+    else
+    {
+        // standard streams: no flush of cout before each read of cin
+        ios::sync_with_stdio(false);
+        cin.tie(nullptr);
+    }
+
+    try
+    {
+        BatchStats stats = runBatch(options, *in, *out);
+        if (!*out)
+        {
+            cerr << "sarcos_quiz: write error\n";
+            return 1;
+        }
+        if (options.stats)
+        {
+            printBatchStats(stats, cerr);
+        }
+    }
+    catch (const exception& e)
+    {
+        cerr << "sarcos_quiz: " << e.what() << "\n";
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+/// @file src/sarcos/augmentedtree.cpp
+
+#include "sarcos/augmentedtree.hpp"
+#include "sarcos/matview.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace
+{
+    /// elements of a matrix, column major
+    inline double* elements(Mat33& mat) { return &mat.col[0].x; }
+    inline const double* elements(const Mat33& mat) { return &mat.col[0].x; }
+
+    /**
+     * @brief add a value to a compensated sum (Neumaier)
+     *
+     * The compensation stops once the sum is infinite or NaN: it would turn into inf - inf.
+     */
+    inline void addCompensated(double& sum, double& compensation, double value)
+    {
+        const double t = sum + value;
+        if (std::isfinite(t))
+        {
+            compensation += (fabs(sum) >= fabs(value)) ? (sum - t) + value : (value - t) + sum;
+        }
+        sum = t;
+    }
+}
+
+const AugmentedTree::NodeId AugmentedTree::kNoNode;
+
+AugmentedTree::AugmentedTree() {}
+
+AugmentedTree::AugmentedTree(const Node* root, size_t count)
+{
+    checkTree(root, count);
+    m_nodes.resize(count);
+
+    // parents and depths in preorder: a stack of the open subtrees, with the last id of each
+    vector<pair<NodeId, size_t>> open;
+    for (size_t i=0; i<count; i++)
+    {
+        while (!open.empty() && i > open.back().second)
+        {
+            open.pop_back();
+        }
+
+        Entry& entry = m_nodes[i];
+        entry.data = root[i].data;
+        entry.parent = open.empty() ? kNoNode : open.back().first;
+        entry.depth = open.size();
+        if (entry.parent != kNoNode)
+        {
+            m_nodes[entry.parent].children.push_back(i);
+        }
+        open.push_back(make_pair(NodeId(i), i + root[i].numChildren));
+    }
+
+    // aggregates bottom up: children come after their parent in preorder
+    for (size_t i=count; i-- > 0;)
+    {
+        recomputeStats(i);
+    }
+}
+
+AugmentedTree::NodeId AugmentedTree::insert(NodeId parent, const Mat33& data)
+{
+    if (parent == kNoNode ? !m_nodes.empty() : parent >= m_nodes.size())
+    {
+        throw invalid_argument("insert needs an existing parent, or an empty tree for the root");
+    }
+
+    const NodeId id = m_nodes.size();
+    Entry entry;
+    entry.data = data;
+    entry.parent = parent;
+    entry.depth = (parent == kNoNode) ? 0 : m_nodes[parent].depth + 1;
+    entry.stats.size = 1;
+    entry.stats.height = 1;
+    entry.stats.min = data;
+    entry.stats.max = data;
+    entry.stats.sum = data;
+    entry.sum = data;
+    entry.compensation = Mat33();
+    m_nodes.push_back(entry);
+
+    if (parent == kNoNode)
+    {
+        return id;
+    }
+    m_nodes[parent].children.push_back(id);
+
+    // a new leaf only grows the aggregates of its ancestors
+    const double* values = elements(data);
+    unsigned int height = 1;
+    for (NodeId a = parent; a != kNoNode; a = m_nodes[a].parent)
+    {
+        SubtreeStats& stats = m_nodes[a].stats;
+        height++;
+        stats.size++;
+        stats.height = max(stats.height, height);
+        double* mins = elements(stats.min);
+        double* maxs = elements(stats.max);
+        for (int k=0; k<9; k++)
+        {
+            mins[k] = min(mins[k], values[k]);
+            maxs[k] = max(maxs[k], values[k]);
+            addToSum(a, k, values[k]);
+        }
+    }
+    return id;
+}
+
+void AugmentedTree::setData(NodeId id, const Mat33& data)
+{
+    const Mat33 oldData = m_nodes.at(id).data;
+    m_nodes[id].data = data;
+
+    const double* oldValues = elements(oldData);
+    const double* newValues = elements(data);
+
+    // sum elements rebuilt below: every ancestor above must rebuild them too
+    bool rebuilt[9] = {};
+
+    // the node and each ancestor see the same change of one contribution
+    for (NodeId a = id; a != kNoNode; a = m_nodes[a].parent)
+    {
+        SubtreeStats& stats = m_nodes[a].stats;
+        double* mins = elements(stats.min);
+        double* maxs = elements(stats.max);
+        const double* sums = elements(m_nodes[a].sum);
+        for (int k=0; k<9; k++)
+        {
+            // a running sum would keep an inf or NaN it once held
+            if (!rebuilt[k] && isfinite(oldValues[k]) && isfinite(newValues[k]) && isfinite(sums[k]))
+            {
+                addToSum(a, k, -oldValues[k]);
+                addToSum(a, k, newValues[k]);
+                rebuilt[k] = !isfinite(sums[k]);
+            }
+            else
+            {
+                recomputeSum(a, k);
+                rebuilt[k] = true;
+            }
+
+            if (!isfinite(oldValues[k]) || !isfinite(newValues[k]))
+            {
+                // NaN compares false both ways, rescan instead
+                rescanExtremum(a, k, false);
+                rescanExtremum(a, k, true);
+                continue;
+            }
+
+            if (newValues[k] <= mins[k])
+            {
+                mins[k] = newValues[k];
+            }
+            else if (oldValues[k] == mins[k])
+            {
+                // the old value may have been the only minimum
+                rescanExtremum(a, k, false);
+            }
+
+            if (newValues[k] >= maxs[k])
+            {
+                maxs[k] = newValues[k];
+            }
+            else if (oldValues[k] == maxs[k])
+            {
+                // the old value may have been the only maximum
+                rescanExtremum(a, k, true);
+            }
+        }
+    }
+}
+
+const Mat33& AugmentedTree::data(NodeId id) const
+{
+    return m_nodes.at(id).data;
+}
+
+AugmentedTree::NodeId AugmentedTree::parent(NodeId id) const
+{
+    return m_nodes.at(id).parent;
+}
+
+const vector<AugmentedTree::NodeId>& AugmentedTree::children(NodeId id) const
+{
+    return m_nodes.at(id).children;
+}
+
+unsigned int AugmentedTree::depth(NodeId id) const
+{
+    return m_nodes.at(id).depth;
+}
+
+const SubtreeStats& AugmentedTree::stats(NodeId id) const
+{
+    return m_nodes.at(id).stats;
+}
+
+unsigned int AugmentedTree::size() const
+{
+    return m_nodes.size();
+}
+
+unsigned int AugmentedTree::height() const
+{
+    return m_nodes.empty() ? 0 : m_nodes[0].stats.height;
+}
+
+void AugmentedTree::recomputeStats(NodeId id)
+{
+    Entry& entry = m_nodes[id];
+    SubtreeStats& stats = entry.stats;
+    stats.size = 1;
+    stats.height = 1;
+    stats.min = entry.data;
+    stats.max = entry.data;
+
+    double* mins = elements(stats.min);
+    double* maxs = elements(stats.max);
+    for (NodeId child : entry.children)
+    {
+        const SubtreeStats& childStats = m_nodes[child].stats;
+        stats.size += childStats.size;
+        stats.height = max(stats.height, childStats.height + 1);
+        for (int k=0; k<9; k++)
+        {
+            mins[k] = min(mins[k], elements(childStats.min)[k]);
+            maxs[k] = max(maxs[k], elements(childStats.max)[k]);
+        }
+    }
+
+    for (int k=0; k<9; k++)
+    {
+        recomputeSum(id, k);
+    }
+}
+
+void AugmentedTree::rescanExtremum(NodeId id, int element, bool isMax)
+{
+    const Entry& entry = m_nodes[id];
+    double value = elements(entry.data)[element];
+    for (NodeId child : entry.children)
+    {
+        const SubtreeStats& childStats = m_nodes[child].stats;
+        double childValue = elements(isMax ? childStats.max : childStats.min)[element];
+        value = isMax ? max(value, childValue) : min(value, childValue);
+    }
+
+    SubtreeStats& stats = m_nodes[id].stats;
+    elements(isMax ? stats.max : stats.min)[element] = value;
+}
+
+void AugmentedTree::addToSum(NodeId id, int element, double value)
+{
+    Entry& entry = m_nodes[id];
+    double& sum = elements(entry.sum)[element];
+    double& compensation = elements(entry.compensation)[element];
+    addCompensated(sum, compensation, value);
+    elements(entry.stats.sum)[element] = sum + compensation;
+}
+
+void AugmentedTree::recomputeSum(NodeId id, int element)
+{
+    Entry& entry = m_nodes[id];
+    double sum = elements(entry.data)[element];
+    double compensation = 0;
+    for (NodeId child : entry.children)
+    {
+        const Entry& childEntry = m_nodes[child];
+        addCompensated(sum, compensation, elements(childEntry.sum)[element]);
+        compensation += elements(childEntry.compensation)[element];
+    }
+    elements(entry.sum)[element] = sum;
+    elements(entry.compensation)[element] = compensation;
+    elements(entry.stats.sum)[element] = sum + compensation;
+}
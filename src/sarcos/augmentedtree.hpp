@@ -0,0 +1,205 @@
+/// @file src/sarcos/augmentedtree.hpp
+
+#ifndef SARCOS_AUGMENTEDTREE_H
+#define SARCOS_AUGMENTEDTREE_H
+
+#include <vector>
+#include "sarcos/math.hpp"
+
+/**
+ * @brief cached aggregate of a subtree
+ *
+ */
+struct SubtreeStats
+{
+    /// number of nodes in the subtree, including its root (numChildren + 1)
+    unsigned int size;
+
+    /// number of levels in the subtree, 1 for a leaf
+    unsigned int height;
+
+    /// element-wise minimum over the data of the subtree
+    Mat33 min;
+
+    /// element-wise maximum over the data of the subtree
+    Mat33 max;
+
+    /// element-wise sum over the data of the subtree
+    Mat33 sum;
+};
+
+/**
+ * @brief Tree of matrices caching the aggregates of every subtree
+ *
+ * Subtree size, height and element-wise min/max/sum are kept up to date on
+ * every insertion and data change, so queries take O(1) instead of a walk.
+ *
+ * Updates visit the ancestors of the changed node, O(depth). A min (max)
+ * element is rescanned over the direct children of an ancestor only when the
+ * changed node held that extremum and moved away from it, or when the old or
+ * new value is infinite or NaN, O(depth * fan-out) at worst.
+ *
+ * Sums are compensated (Neumaier): a data change subtracts the old value and
+ * adds the new one on each ancestor, O(depth), without cancelling against
+ * huge values. An infinite or NaN value, or a sum overflowing, would stick in
+ * a running sum: that element is rebuilt from the data and the sums of the
+ * direct children instead, for this ancestor and every one above it.
+ */
+class AugmentedTree
+{
+public:
+    /// node handle, the index of insertion
+    typedef unsigned int NodeId;
+
+    /// no node, e.g. the parent of the root
+    static const NodeId kNoNode = ~0u;
+
+    /**
+     * @brief Construct an empty tree
+     *
+     */
+    AugmentedTree();
+
+    /**
+     * @brief Construct from a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+     *
+     * Node ids follow the preorder of the nodes, the root is 0.
+     * Takes O(n), all aggregates are computed bottom up.
+     * Throws std::invalid_argument if validateTree() rejects the tree.
+     *
+     * @param root - root of the tree, followed by the rest of its nodes in preorder
+     * @param count - number of nodes
+     */
+    AugmentedTree(const Node* root, size_t count);
+
+    /**
+     * @brief add a leaf node
+     *
+     * @param parent - parent node, kNoNode to add the root of an empty tree
+     * @param data - matrix data
+     * @return NodeId - the new node
+     */
+    NodeId insert(NodeId parent, const Mat33& data);
+
+    /**
+     * @brief change the data of a node
+     *
+     * @param id - node
+     * @param data - new matrix data
+     */
+    void setData(NodeId id, const Mat33& data);
+
+    /**
+     * @brief matrix data of a node
+     *
+     * @param id - node
+     * @return const Mat33&
+     */
+    const Mat33& data(NodeId id) const;
+
+    /**
+     * @brief parent of a node, kNoNode for the root
+     *
+     * @param id - node
+     * @return NodeId
+     */
+    NodeId parent(NodeId id) const;
+
+    /**
+     * @brief direct children of a node, in insertion order
+     *
+     * @param id - node
+     * @return const std::vector<NodeId>&
+     */
+    const std::vector<NodeId>& children(NodeId id) const;
+
+    /**
+     * @brief distance of a node from the root, 0 for the root
+     *
+     * @param id - node
+     * @return unsigned int
+     */
+    unsigned int depth(NodeId id) const;
+
+    /**
+     * @brief cached aggregates of the subtree of a node
+     *
+     * @param id - node
+     * @return const SubtreeStats&
+     */
+    const SubtreeStats& stats(NodeId id) const;
+
+    /**
+     * @brief number of nodes in the tree
+     *
+     * @return unsigned int
+     */
+    unsigned int size() const;
+
+    /**
+     * @brief number of levels of the whole tree, 0 when empty
+     *
+     * @return unsigned int
+     */
+    unsigned int height() const;
+
+private:
+
+    /**
+     * @brief a node and its cached aggregates
+     *
+     */
+    struct Entry
+    {
+        Mat33 data;
+        NodeId parent;
+        unsigned int depth;
+        std::vector<NodeId> children;
+        SubtreeStats stats;
+
+        /// running sum of the subtree and its compensation, stats.sum is their total
+        Mat33 sum;
+        Mat33 compensation;
+    };
+
+    /**
+     * @brief aggregates of a node from its data and the aggregates of its children
+     *
+     * @param id - node
+     */
+    void recomputeStats(NodeId id);
+
+    /**
+     * @brief rescan one element of the min or max of a node over its data and its children
+     *
+     * @param id - node
+     * @param element - element index, 0..8 in column major order
+     * @param isMax - rescan the max, otherwise the min
+     */
+    void rescanExtremum(NodeId id, int element, bool isMax);
+
+    /**
+     * @brief add a value to one element of the running sum of a node
+     *
+     * @param id - node
+     * @param element - element index, 0..8 in column major order
+     * @param value - value to add
+     */
+    void addToSum(NodeId id, int element, double value);
+
+    /**
+     * @brief rebuild one element of the sum of a node from its data and the sums of its children
+     *
+     * @param id - node
+     * @param element - element index, 0..8 in column major order
+     */
+    void recomputeSum(NodeId id, int element);
+
+    /**
+     * @brief all nodes, indexed by id
+     *
+     */
+    std::vector<Entry> m_nodes;
+};
+
+#endif // SARCOS_AUGMENTEDTREE_H
@@ -0,0 +1,772 @@
+/// @file src/sarcos/batch.cpp
+
+#include "sarcos/batch.hpp"
+#include "sarcos/math.hpp"
+#include "sarcos/matview.hpp"
+#include "sarcos/parallel.hpp"
+#include "sarcos/pipeline.hpp"
+#include "sarcos/prettyprinter.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    /// smallest number of records worth a thread
+    const size_t kMinRecordsPerThread = 1024;
+
+    /// significant digits of a compact value, enough to read back the same double
+    const int kCompactDigits = 17;
+
+    /**
+     * @brief number of doubles in a record
+     *
+     */
+    int valuesPerRecord(RecordType type)
+    {
+        return type == RecordType::Vec3 ? 3 : 9;
+    }
+
+    /**
+     * @brief parse a non negative integer argument
+     *
+     * @param text - argument
+     * @param value - output
+     * @return true if the whole argument is a number
+     */
+    bool parseCount(const char* text, size_t& value)
+    {
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long parsed = strtoull(text, &end, 10);
+        if (end == text || *end != '\0' || errno != 0 || text[0] == '-')
+        {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    /**
+     * @brief Reads records in text or binary form
+     *
+     */
+    class RecordReader
+    {
+    public:
+        RecordReader(const BatchOptions& options, istream& in)
+        : m_in(in)
+        , m_type(options.type)
+        , m_binary(options.inputFormat == InputFormat::Binary)
+        , m_width(valuesPerRecord(options.type))
+        , m_line(0)
+        , m_record(0)
+        , m_bytes(0)
+        {}
+
+        /**
+         * @brief read up to maxRecords records, replacing the content of values and parents
+         *
+         * @param maxRecords - most records to read
+         * @param values - output, the doubles of each record
+         * @param parents - output, the parent of each node record
+         * @return size_t - number of records read, 0 at the end of the input
+         */
+        size_t read(size_t maxRecords, vector<double>& values, vector<int>& parents)
+        {
+            values.resize(maxRecords * m_width);
+            parents.resize(m_type == RecordType::Node ? maxRecords : 0);
+
+            size_t count = 0;
+            while (count < maxRecords)
+            {
+                int* parent = parents.empty() ? nullptr : &parents[count];
+                double* record = &values[count * m_width];
+                if (!(m_binary ? readBinary(record, parent) : readText(record, parent)))
+                {
+                    break;
+                }
+                count++;
+                m_record++;
+            }
+
+            values.resize(count * m_width);
+            parents.resize(parents.empty() ? 0 : count);
+            return count;
+        }
+
+        /// bytes read so far
+        size_t bytesRead() const { return m_bytes; }
+
+    private:
+
+        /**
+         * @brief read one record from the next non blank line
+         *
+         * @return false at the end of the input
+         */
+        bool readText(double* values, int* parent)
+        {
+            while (getline(m_in, m_lineText))
+            {
+                m_line++;
+                m_bytes += m_lineText.size() + 1;
+
+                const char* p = m_lineText.c_str();
+                p += strspn(p, " \t\r");
+                if (*p == '\0' || *p == '#')
+                {
+                    continue;
+                }
+
+                char* end = nullptr;
+                if (parent)
+                {
+                    long value = strtol(p, &end, 10);
+                    if (end == p || value < -1 || value > INT32_MAX)
+                    {
+                        fail("expected a parent index");
+                    }
+                    *parent = int(value);
+                    p = end;
+                }
+                for (int k=0; k<m_width; k++)
+                {
+                    values[k] = strtod(p, &end);
+                    if (end == p)
+                    {
+                        fail("expected " + to_string(m_width) + " values");
+                    }
+                    p = end;
+                }
+                p += strspn(p, " \t\r");
+                if (*p != '\0')
+                {
+                    fail("unexpected text after " + to_string(m_width) + " values");
+                }
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief read one packed record
+         *
+         * @return false at the end of the input
+         */
+        bool readBinary(double* values, int* parent)
+        {
+            if (parent)
+            {
+                int32_t value;
+                if (!readBytes(&value, sizeof(value), true))
+                {
+                    return false;
+                }
+                *parent = value;
+            }
+            return readBytes(values, m_width * sizeof(double), parent == nullptr);
+        }
+
+        /**
+         * @brief read exactly size bytes
+         *
+         * @param dst - output
+         * @param size - number of bytes
+         * @param recordStart - the end of the input is allowed before the first byte
+         * @return false at the end of the input
+         */
+        bool readBytes(void* dst, size_t size, bool recordStart)
+        {
+            m_in.read(static_cast<char*>(dst), size);
+            size_t got = m_in.gcount();
+            m_bytes += got;
+            if (got == size)
+            {
+                return true;
+            }
+            if (got == 0 && recordStart)
+            {
+                return false;
+            }
+            fail("truncated record");
+            return false;
+        }
+
+        /**
+         * @brief throw with the position of the current record
+         *
+         */
+        [[noreturn]] void fail(const string& reason)
+        {
+            string where = m_binary ? "record " + to_string(m_record + 1) : "line " + to_string(m_line);
+            throw runtime_error(where + ": " + reason);
+        }
+
+        istream& m_in;
+        RecordType m_type;
+        bool m_binary;
+        int m_width;
+        size_t m_line;
+        size_t m_record;
+        size_t m_bytes;
+        string m_lineText;
+    };
+
+    /**
+     * @brief Writes records, pretty printed or compact
+     *
+     */
+    class RecordWriter
+    {
+    public:
+        RecordWriter(const BatchOptions& options, ostream& out)
+        : m_out(out)
+        , m_compact(options.outputFormat == OutputFormat::Compact)
+        {
+            m_printer.setPrecision(options.precision);
+            m_printer.setOutputStream(out);
+        }
+
+        void write(const Vec3& vec)
+        {
+            if (m_compact)
+            {
+                writeValues(&vec.x, 3);
+            }
+            else
+            {
+                m_printer.print(vec);
+            }
+        }
+
+        void write(const Mat33& mat)
+        {
+            if (m_compact)
+            {
+                writeValues(&mat.col[0].x, 9);
+            }
+            else
+            {
+                m_printer.print(mat);
+            }
+        }
+
+        void write(double value)
+        {
+            if (m_compact)
+            {
+                writeValues(&value, 1);
+            }
+            else
+            {
+                m_out << m_printer.format(value) << '\n';
+            }
+        }
+
+        /// compact node record, as read: parent index, then the data
+        void write(const Mat33& data, long parent)
+        {
+            m_out << parent << ' ';
+            writeValues(&data.col[0].x, 9);
+        }
+
+        /// pretty node, with its preorder index
+        void write(const Node& node, size_t index, long parent)
+        {
+            m_out << "Node " << index << " (parent " << parent << ", " << node.numChildren << " below):\n";
+            m_printer.print(node.data);
+        }
+
+    private:
+        /// compact values: every digit needed to read back the same doubles, no display policy
+        void writeValues(const double* values, int count)
+        {
+            char buf[32];
+            for (int k=0; k<count; k++)
+            {
+                if (k > 0)
+                {
+                    m_out << ' ';
+                }
+                m_out.write(buf, snprintf(buf, sizeof(buf), "%.*g", kCompactDigits, values[k]));
+            }
+            m_out << '\n';
+        }
+
+        ostream& m_out;
+        bool m_compact;
+        PrettyPrinter m_printer;
+    };
+
+    /**
+     * @brief split interleaved pairs of records into the firsts and the seconds
+     *
+     */
+    template <typename T>
+    void splitPairs(const T* records, size_t numPairs, vector<T>& firsts, vector<T>& seconds)
+    {
+        firsts.resize(numPairs);
+        seconds.resize(numPairs);
+        for (size_t i=0; i<numPairs; i++)
+        {
+            firsts[i] = records[2*i];
+            seconds[i] = records[2*i + 1];
+        }
+    }
+
+    /**
+     * @brief batch of vec3 or mat33 records, with the results of the operation
+     *
+     */
+    struct RecordBatch
+    {
+        /// doubles of the records read
+        vector<double> values;
+
+        /// number of records read
+        size_t count = 0;
+
+        /// results of dot
+        vector<double> dots;
+
+        /// results of the mat33 operations
+        vector<Mat33> results;
+
+        /// set by BatchComputer: the batch now holds its results
+        bool computed = false;
+
+        /// number of results to write, set by BatchComputer
+        size_t resultCount = 0;
+
+        /// number of records, counted by the pipeline stages: read, then to write once computed
+        size_t size() const { return computed ? resultCount : count; }
+    };
+
+    /**
+     * @brief read the records batch by batch
+     *
+     * @param options - record type, operation and batch size
+     * @param reader - input records, outlives the generator
+     * @param stats - output, records read
+     */
+    Generator<RecordBatch> readBatches(const BatchOptions& options, RecordReader& reader, BatchStats& stats)
+    {
+        const bool pairs = options.operation == Operation::Dot || options.operation == Operation::Multiply;
+        size_t batchSize = max<size_t>(1, options.batchSize);
+        if (pairs)
+        {
+            // whole pairs in every batch
+            batchSize += batchSize % 2;
+        }
+
+        vector<int> parents;
+        for (;;)
+        {
+            RecordBatch batch;
+            batch.count = reader.read(batchSize, batch.values, parents);
+            if (batch.count == 0)
+            {
+                break;
+            }
+            stats.recordsIn += batch.count;
+            if (pairs && batch.count % 2 != 0)
+            {
+                throw runtime_error("operation needs pairs of records, got an odd number of records");
+            }
+            co_yield batch;
+        }
+    }
+
+    /**
+     * @brief Applies the operation to batches of vec3 and mat33 records
+     *
+     */
+    class BatchComputer
+    {
+    public:
+        explicit BatchComputer(const BatchOptions& options)
+        : m_options(options)
+        {}
+
+        void operator()(RecordBatch& batch)
+        {
+            compute(batch);
+            batch.resultCount = batch.dots.size() + batch.results.size();
+            if (m_options.type == RecordType::Vec3 && m_options.operation != Operation::Dot)
+            {
+                // vec3 records are copied as read
+                batch.resultCount = batch.count;
+            }
+            batch.computed = true;
+        }
+
+    private:
+        void compute(RecordBatch& batch)
+        {
+            const size_t count = batch.count;
+            const unsigned int threads = m_options.threads;
+            if (m_options.type == RecordType::Vec3)
+            {
+                if (m_options.operation == Operation::Dot)
+                {
+                    splitPairs(reinterpret_cast<const Vec3*>(batch.values.data()), count / 2, m_vecs1, m_vecs2);
+                    batch.dots.resize(count / 2);
+                    parallelFor(batch.dots.size(), kMinRecordsPerThread, threads, [&](size_t begin, size_t end)
+                    {
+                        dotProducts(&m_vecs1[begin], &m_vecs2[begin], &batch.dots[begin], end - begin);
+                    });
+                }
+                return;
+            }
+
+            Mat33* mats = reinterpret_cast<Mat33*>(batch.values.data());
+            if (m_options.operation == Operation::Multiply)
+            {
+                splitPairs(mats, count / 2, m_mats1, m_mats2);
+                batch.results.resize(count / 2);
+                parallelFor(batch.results.size(), kMinRecordsPerThread, threads, [&](size_t begin, size_t end)
+                {
+                    multiplyMats(&m_mats1[begin], &m_mats2[begin], &batch.results[begin], end - begin);
+                });
+            }
+            else if (m_options.operation == Operation::Transpose)
+            {
+                parallelFor(count, kMinRecordsPerThread, threads, [&](size_t begin, size_t end)
+                {
+                    transposeMats(mats + begin, end - begin);
+                });
+                batch.results.assign(mats, mats + count);
+            }
+            else
+            {
+                batch.results.resize(count);
+                parallelFor(count, kMinRecordsPerThread, threads, [&](size_t begin, size_t end)
+                {
+                    copyMats(mats + begin, &batch.results[begin], end - begin);
+                });
+            }
+        }
+
+        const BatchOptions& m_options;
+
+        /// split pairs, reused across batches
+        vector<Vec3> m_vecs1, m_vecs2;
+        vector<Mat33> m_mats1, m_mats2;
+    };
+
+    /**
+     * @brief write the results of a batch
+     *
+     */
+    void writeBatch(const BatchOptions& options, const RecordBatch& batch, RecordWriter& writer, BatchStats& stats)
+    {
+        if (options.type == RecordType::Mat33)
+        {
+            for (const Mat33& result : batch.results)
+            {
+                writer.write(result);
+            }
+            stats.recordsOut += batch.results.size();
+        }
+        else if (options.operation == Operation::Dot)
+        {
+            for (double dot : batch.dots)
+            {
+                writer.write(dot);
+            }
+            stats.recordsOut += batch.dots.size();
+        }
+        else
+        {
+            const Vec3* vecs = reinterpret_cast<const Vec3*>(batch.values.data());
+            for (size_t i=0; i<batch.count; i++)
+            {
+                writer.write(vecs[i]);
+            }
+            stats.recordsOut += batch.count;
+        }
+    }
+
+    /**
+     * @brief vec3 and mat33 records, processed and written batch by batch
+     *
+     * With options.pipeline, reading, computing and writing run as coroutine
+     * stages on three threads, overlapping across batches.
+     */
+    void runRecords(const BatchOptions& options, RecordReader& reader, RecordWriter& writer, BatchStats& stats)
+    {
+        Generator<RecordBatch> batches = readBatches(options, reader, stats);
+        BatchComputer compute(options);
+        if (!options.pipeline)
+        {
+            while (optional<RecordBatch> batch = batches.next())
+            {
+                compute(*batch);
+                writeBatch(options, *batch, writer, stats);
+            }
+            return;
+        }
+
+        PipelineStats pipelineStats = runPipeline(batches, ref(compute), [&](RecordBatch& batch)
+        {
+            writeBatch(options, batch, writer, stats);
+        });
+        stats.stages = pipelineStats.stages;
+    }
+
+    /**
+     * @brief node records, built into one tree
+     *
+     * Pretty output lists the nodes in preorder. Compact output keeps the
+     * input order and parent indices, so it reads back as node records.
+     */
+    void runNodes(const BatchOptions& options, RecordReader& reader, RecordWriter& writer, BatchStats& stats)
+    {
+        vector<Mat33> data;
+        vector<int> parents;
+        vector<double> values;
+        vector<int> batchParents;
+        while (size_t count = reader.read(max<size_t>(1, options.batchSize), values, batchParents))
+        {
+            const Mat33* mats = reinterpret_cast<const Mat33*>(values.data());
+            data.insert(data.end(), mats, mats + count);
+            parents.insert(parents.end(), batchParents.begin(), batchParents.end());
+            stats.recordsIn += count;
+        }
+        if (data.empty())
+        {
+            return;
+        }
+
+        if (options.operation == Operation::Transpose)
+        {
+            parallelFor(data.size(), kMinRecordsPerThread, options.threads, [&](size_t begin, size_t end)
+            {
+                transposeMats(&data[begin], end - begin);
+            });
+        }
+
+        // built also for compact output, which checks the parents
+        Node* root = buildTreeFromParents(data.data(), parents.data(), data.size(), options.threads);
+        if (options.outputFormat == OutputFormat::Compact)
+        {
+            for (size_t i=0; i<data.size(); i++)
+            {
+                writer.write(data[i], parents[i]);
+            }
+            stats.recordsOut += data.size();
+            destroyTree(root);
+            return;
+        }
+
+        // preorder parent of each node: a stack of the open subtrees, with the last index of each
+        vector<pair<size_t, size_t>> open;
+        for (size_t i=0; i<data.size(); i++)
+        {
+            while (!open.empty() && i > open.back().second)
+            {
+                open.pop_back();
+            }
+            writer.write(root[i], i, open.empty() ? -1 : long(open.back().first));
+            open.push_back(make_pair(i, i + root[i].numChildren));
+        }
+        stats.recordsOut += data.size();
+
+        destroyTree(root);
+    }
+}
+
+bool parseBatchOptions(int argc, const char* const* argv, BatchOptions& options, string& error)
+{
+    for (int i=1; i<argc; i++)
+    {
+        const string arg = argv[i];
+
+        // flags
+        if (arg == "--help" || arg == "-h")
+        {
+            options.help = true;
+            continue;
+        }
+        if (arg == "--stats")
+        {
+            options.stats = true;
+            continue;
+        }
+        if (arg == "--demo")
+        {
+            options.demo = true;
+            continue;
+        }
+        if (arg == "--pipeline")
+        {
+            options.pipeline = true;
+            continue;
+        }
+
+        // options with a value
+        if (i + 1 >= argc)
+        {
+            error = "unknown option or missing value: " + arg;
+            return false;
+        }
+        const string value = argv[++i];
+        size_t count = 0;
+        bool valid = true;
+        if (arg == "--input" || arg == "-i")
+        {
+            options.inputPath = value;
+        }
+        else if (arg == "--output" || arg == "-o")
+        {
+            options.outputPath = value;
+        }
+        else if (arg == "--type")
+        {
+            valid = value == "vec3" || value == "mat33" || value == "node";
+            options.type = value == "vec3" ? RecordType::Vec3 : (value == "node" ? RecordType::Node : RecordType::Mat33);
+        }
+        else if (arg == "--op")
+        {
+            valid = value == "copy" || value == "transpose" || value == "dot" || value == "multiply";
+            options.operation = value == "transpose" ? Operation::Transpose
+                              : value == "dot" ? Operation::Dot
+                              : value == "multiply" ? Operation::Multiply
+                              : Operation::Copy;
+        }
+        else if (arg == "--input-format")
+        {
+            valid = value == "text" || value == "binary";
+            options.inputFormat = value == "binary" ? InputFormat::Binary : InputFormat::Text;
+        }
+        else if (arg == "--output-format")
+        {
+            valid = value == "pretty" || value == "compact";
+            options.outputFormat = value == "compact" ? OutputFormat::Compact : OutputFormat::Pretty;
+        }
+        else if (arg == "--threads")
+        {
+            valid = parseCount(value.c_str(), count) && count <= 1024;
+            options.threads = count;
+        }
+        else if (arg == "--batch-size")
+        {
+            valid = parseCount(value.c_str(), count) && count > 0;
+            options.batchSize = count;
+        }
+        else if (arg == "--io-buffer")
+        {
+            valid = parseCount(value.c_str(), count);
+            options.ioBufferSize = count;
+        }
+        else if (arg == "--precision")
+        {
+            valid = parseCount(value.c_str(), count) && count <= 30;
+            options.precision = count;
+        }
+        else
+        {
+            error = "unknown option: " + arg;
+            return false;
+        }
+
+        if (!valid)
+        {
+            error = "invalid value for " + arg + ": " + value;
+            return false;
+        }
+    }
+
+    // operations each record type supports
+    const bool supported =
+        options.operation == Operation::Copy ||
+        (options.operation == Operation::Transpose && options.type != RecordType::Vec3) ||
+        (options.operation == Operation::Dot && options.type == RecordType::Vec3) ||
+        (options.operation == Operation::Multiply && options.type == RecordType::Mat33);
+    if (!supported)
+    {
+        error = "operation not supported for this record type";
+        return false;
+    }
+    return true;
+}
+
+void printUsage(ostream& out)
+{
+    out << "Usage: sarcos_quiz [options]\n"
+        << "\n"
+        << "Reads Vec3, Mat33 or Node records, applies an operation and writes the results.\n"
+        << "\n"
+        << "  -i, --input PATH          input file, - for standard input (default -)\n"
+        << "  -o, --output PATH         output file, - for standard output (default -)\n"
+        << "  --type vec3|mat33|node    record type (default mat33)\n"
+        << "  --op copy|transpose|dot|multiply\n"
+        << "                            operation (default copy), dot and multiply take pairs of records\n"
+        << "  --input-format text|binary   (default text)\n"
+        << "  --output-format pretty|compact   (default pretty)\n"
+        << "  --threads N               threads per batch, 0 for all hardware threads (default 1)\n"
+        << "  --batch-size N            records per batch (default 4096)\n"
+        << "  --io-buffer BYTES         file stream buffer size (default 65536)\n"
+        << "  --precision N             decimal places of pretty output (default 3)\n"
+        << "  --pipeline                overlap reading, computing and writing on 3 threads (vec3, mat33)\n"
+        << "  --stats                   report throughput on standard error\n"
+        << "  --demo                    run the demonstration\n"
+        << "  -h, --help                show this help\n"
+        << "\n"
+        << "Text records, one per line:\n"
+        << "  vec3:  x y z\n"
+        << "  mat33: x1 y1 z1 x2 y2 z2 x3 y3 z3 (column by column)\n"
+        << "  node:  parent x1 y1 z1 x2 y2 z2 x3 y3 z3 (parent: index of an earlier node, -1 for the root)\n"
+        << "Binary records pack the same fields: doubles, int32 parent, host byte order.\n";
+}
+
+BatchStats runBatch(const BatchOptions& options, istream& in, ostream& out)
+{
+    const auto start = chrono::steady_clock::now();
+
+    BatchStats stats;
+    RecordReader reader(options, in);
+    RecordWriter writer(options, out);
+    if (options.type == RecordType::Node)
+    {
+        runNodes(options, reader, writer, stats);
+    }
+    else
+    {
+        runRecords(options, reader, writer, stats);
+    }
+    out.flush();
+
+    stats.bytesIn = reader.bytesRead();
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+void printBatchStats(const BatchStats& stats, ostream& out)
+{
+    const double seconds = max(stats.seconds, 1e-9);
+    out << "records in:  " << stats.recordsIn << "\n"
+        << "records out: " << stats.recordsOut << "\n"
+        << "bytes in:    " << stats.bytesIn << "\n"
+        << "seconds:     " << stats.seconds << "\n"
+        << "records/s:   " << stats.recordsIn / seconds << "\n"
+        << "MB/s in:     " << stats.bytesIn / seconds / 1e6 << "\n";
+    for (const StageStats& stage : stats.stages)
+    {
+        out << "stage " << stage.name << ": " << stage.batches << " batches, " << stage.items << " records, "
+            << stage.busySeconds << " s busy, " << stage.itemsPerSecond() << " records/s, " << stage.waits << " waits\n";
+    }
+}
@@ -0,0 +1,177 @@
+/// @file src/sarcos/batch.hpp
+
+#ifndef SARCOS_BATCH_H
+#define SARCOS_BATCH_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "sarcos/pipeline.hpp"
+
+/**
+ * @brief kind of record in a batch input
+ *
+ * Text input has one record per line (blank lines and lines starting with # are skipped):
+ *
+ * - vec3:  x y z
+ *
+ * - mat33: x1 y1 z1 x2 y2 z2 x3 y3 z3 (column by column, as Mat33::col)
+ *
+ * - node:  parent x1 y1 z1 x2 y2 z2 x3 y3 z3, parent is the index of an
+ *          earlier node record, -1 for the root (see buildTreeFromParents())
+ *
+ * Binary input packs the same fields in host byte order: doubles, and a
+ * 32 bit signed integer for the parent of a node.
+ */
+enum class RecordType
+{
+    Vec3,
+    Mat33,
+    Node
+};
+
+/**
+ * @brief operation applied to the records
+ *
+ * dot takes consecutive pairs of vec3 records, multiply consecutive pairs
+ * of mat33 records (first * second). transpose applies to mat33 and node
+ * records, copy to all.
+ */
+enum class Operation
+{
+    Copy,
+    Transpose,
+    Dot,
+    Multiply
+};
+
+/**
+ * @brief encoding of the input records
+ *
+ */
+enum class InputFormat
+{
+    Text,
+    Binary
+};
+
+/**
+ * @brief encoding of the output records
+ *
+ * pretty prints through PrettyPrinter, compact writes one record per line,
+ * values separated by a space, with the 17 significant digits that read back
+ * the same doubles (nodes: in input order, parent index, then the data).
+ * Compact output of a copy reads back as the input records.
+ */
+enum class OutputFormat
+{
+    Pretty,
+    Compact
+};
+
+/**
+ * @brief settings of a batch run, see printUsage()
+ *
+ */
+struct BatchOptions
+{
+    /// input file, "-" for standard input
+    std::string inputPath = "-";
+
+    /// output file, "-" for standard output
+    std::string outputPath = "-";
+
+    RecordType type = RecordType::Mat33;
+    Operation operation = Operation::Copy;
+    InputFormat inputFormat = InputFormat::Text;
+    OutputFormat outputFormat = OutputFormat::Pretty;
+
+    /// threads computing each batch, 0 for one per hardware thread
+    unsigned int threads = 1;
+
+    /// records read, processed and written at a time
+    size_t batchSize = 4096;
+
+    /// size of the file stream buffers in bytes, 0 for the library default
+    size_t ioBufferSize = 1 << 16;
+
+    /// number of decimal places of pretty output
+    int precision = 3;
+
+    /// read, compute and write vec3 and mat33 batches as overlapping pipeline stages
+    bool pipeline = false;
+
+    /// report throughput on standard error
+    bool stats = false;
+
+    /// run the demonstration instead of a batch
+    bool demo = false;
+
+    /// print usage and exit
+    bool help = false;
+};
+
+/**
+ * @brief counters of a batch run
+ *
+ */
+struct BatchStats
+{
+    /// records read
+    size_t recordsIn = 0;
+
+    /// records written
+    size_t recordsOut = 0;
+
+    /// bytes read
+    size_t bytesIn = 0;
+
+    /// wall time of the run
+    double seconds = 0;
+
+    /// counters of the read, transform and write stages of a pipeline run, empty otherwise
+    std::vector<StageStats> stages;
+};
+
+/**
+ * @brief parse command line arguments
+ *
+ * @param argc - number of arguments, including the program name
+ * @param argv - arguments
+ * @param options - output, parsed options on top of the defaults
+ * @param error - output, reason when the arguments are invalid
+ * @return true if the arguments are valid
+ */
+bool parseBatchOptions(int argc, const char* const* argv, BatchOptions& options, std::string& error);
+
+/**
+ * @brief print the command line usage
+ *
+ * @param out - output stream
+ */
+void printUsage(std::ostream& out);
+
+/**
+ * @brief read, process and write all records of a stream
+ *
+ * Throws std::runtime_error on malformed input (with the record or line
+ * number) and std::invalid_argument on an inconsistent node tree.
+ *
+ * @param options - record type, operation, formats, threads, batch size and precision
+ * @param in - input records
+ * @param out - output records
+ * @return BatchStats
+ */
+BatchStats runBatch(const BatchOptions& options, std::istream& in, std::ostream& out);
+
+/**
+ * @brief print the counters of a run: records, bytes, time and throughput
+ *
+ * @param stats - counters of a run
+ * @param out - output stream
+ */
+void printBatchStats(const BatchStats& stats, std::ostream& out);
+
+#endif // SARCOS_BATCH_H
@@ -0,0 +1,109 @@
+/// @file src/sarcos/cachedmat.cpp
+
+#include "sarcos/cachedmat.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    /// offset of an element in a matrix, col[col] holds the column as x, y, z
+    inline int elementOffset(int row, int col)
+    {
+        if (row < 0 || row > 2 || col < 0 || col > 2)
+        {
+            throw out_of_range("matrix element out of range");
+        }
+        return 3 * col + row;
+    }
+}
+
+CachedMat33::CachedMat33()
+: m_mat()
+, m_version(1) // ahead of the empty layout
+{}
+
+CachedMat33::CachedMat33(const Mat33& mat)
+: m_mat(mat)
+, m_version(1)
+{}
+
+const Mat33& CachedMat33::get() const
+{
+    return m_mat;
+}
+
+double CachedMat33::get(int row, int col) const
+{
+    return (&m_mat.col[0].x)[elementOffset(row, col)];
+}
+
+void CachedMat33::set(const Mat33& mat)
+{
+    m_mat = mat;
+    m_version++;
+}
+
+void CachedMat33::set(int row, int col, double value)
+{
+    (&m_mat.col[0].x)[elementOffset(row, col)] = value;
+    m_version++;
+}
+
+unsigned long CachedMat33::version() const
+{
+    return m_version;
+}
+
+CachedTree::CachedTree(Node* root, size_t count)
+: m_root(root)
+, m_versions(count, 1)
+, m_layouts(count)
+{
+    checkTree(root, count);
+}
+
+const Node* CachedTree::root() const
+{
+    return m_root;
+}
+
+size_t CachedTree::size() const
+{
+    return m_versions.size();
+}
+
+const Mat33& CachedTree::data(size_t index) const
+{
+    checkIndex(index);
+    return m_root[index].data;
+}
+
+void CachedTree::setData(size_t index, const Mat33& data)
+{
+    checkIndex(index);
+    m_root[index].data = data;
+    m_versions[index]++;
+}
+
+void CachedTree::set(size_t index, int row, int col, double value)
+{
+    checkIndex(index);
+    (&m_root[index].data.col[0].x)[elementOffset(row, col)] = value;
+    m_versions[index]++;
+}
+
+unsigned long CachedTree::version(size_t index) const
+{
+    checkIndex(index);
+    return m_versions[index];
+}
+
+void CachedTree::checkIndex(size_t index) const
+{
+    if (index >= m_versions.size())
+    {
+        throw out_of_range("node index out of range");
+    }
+}
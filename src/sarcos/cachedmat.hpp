@@ -0,0 +1,194 @@
+/// @file src/sarcos/cachedmat.hpp
+
+#ifndef SARCOS_CACHEDMAT_H
+#define SARCOS_CACHEDMAT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "sarcos/math.hpp"
+
+/**
+ * @brief print layout of a matrix, as computed by a PrettyPrinter
+ *
+ * Valid while both stamps match: the version of the data it was computed
+ * from, and the format stamp of the printer settings it was computed with
+ * (see PrettyPrinter::getFormatStamp()).
+ */
+struct MatLayout
+{
+    /// version of the data, 0 before the first layout
+    unsigned long version = 0;
+
+    /// format stamp of the printer, 0 before the first layout
+    unsigned long formatStamp = 0;
+
+    /// width of each column, including the space buffer before it
+    int widths[3] = {0, 0, 0};
+
+    /// formatted values, column major like Mat33
+    std::string cells[9];
+
+    /// complete output of the print
+    std::string text;
+};
+
+/**
+ * @brief Mat33 with its print layout cached
+ *
+ * Writes go through the setters, which bump the version. PrettyPrinter::print()
+ * formats and measures the values only when the version or the printer
+ * settings changed since the last print; otherwise it writes the cached text.
+ *
+ * The cache is updated by const prints: a CachedMat33 is not safe to print
+ * from several threads at once.
+ */
+class CachedMat33
+{
+public:
+    /**
+     * @brief Construct a zero matrix
+     *
+     */
+    CachedMat33();
+
+    /**
+     * @brief Construct from a matrix
+     *
+     * @param mat - matrix
+     */
+    explicit CachedMat33(const Mat33& mat);
+
+    /**
+     * @brief get the matrix
+     *
+     * @return const Mat33&
+     */
+    const Mat33& get() const;
+
+    /**
+     * @brief get an element
+     *
+     * @param row - row index, 0 to 2
+     * @param col - column index, 0 to 2
+     * @return double
+     */
+    double get(int row, int col) const;
+
+    /**
+     * @brief replace the matrix, invalidates the layout
+     *
+     * @param mat - matrix
+     */
+    void set(const Mat33& mat);
+
+    /**
+     * @brief replace an element, invalidates the layout
+     *
+     * @param row - row index, 0 to 2
+     * @param col - column index, 0 to 2
+     * @param value - new value
+     */
+    void set(int row, int col, double value);
+
+    /**
+     * @brief get the version, bumped by every setter
+     *
+     * @return unsigned long
+     */
+    unsigned long version() const;
+
+private:
+    friend class PrettyPrinter;
+
+    Mat33 m_mat;
+    unsigned long m_version;
+    mutable MatLayout m_layout;
+};
+
+/**
+ * @brief Node tree with the print layout of every node cached
+ *
+ * Wraps a tree built by buildTreeFromParents() or buildTreeFromChildCounts(),
+ * nodes are addressed by their preorder index. Node data must be changed
+ * through setData() or set() to invalidate its layout; the tree itself is
+ * not owned and must outlive the wrapper.
+ *
+ * Like CachedMat33, not safe to print from several threads at once.
+ */
+class CachedTree
+{
+public:
+    /**
+     * @brief Construct on a tree
+     *
+     * Throws std::invalid_argument if validateTree() rejects the tree.
+     *
+     * @param root - root of the tree, followed by the rest of its nodes in preorder
+     * @param count - number of nodes
+     */
+    CachedTree(Node* root, size_t count);
+
+    /**
+     * @brief get the root of the tree
+     *
+     * @return const Node*
+     */
+    const Node* root() const;
+
+    /**
+     * @brief get the number of nodes
+     *
+     * @return size_t
+     */
+    size_t size() const;
+
+    /**
+     * @brief get the data of a node
+     *
+     * @param index - preorder index of the node
+     * @return const Mat33&
+     */
+    const Mat33& data(size_t index) const;
+
+    /**
+     * @brief replace the data of a node, invalidates its layout
+     *
+     * @param index - preorder index of the node
+     * @param data - matrix data
+     */
+    void setData(size_t index, const Mat33& data);
+
+    /**
+     * @brief replace an element of the data of a node, invalidates its layout
+     *
+     * @param index - preorder index of the node
+     * @param row - row index, 0 to 2
+     * @param col - column index, 0 to 2
+     * @param value - new value
+     */
+    void set(size_t index, int row, int col, double value);
+
+    /**
+     * @brief get the version of the data of a node, bumped by every setter
+     *
+     * @param index - preorder index of the node
+     * @return unsigned long
+     */
+    unsigned long version(size_t index) const;
+
+private:
+    friend class PrettyPrinter;
+
+    /**
+     * @brief throw std::out_of_range unless index is a node of the tree
+     *
+     */
+    void checkIndex(size_t index) const;
+
+    Node* m_root;
+    std::vector<unsigned long> m_versions;
+    mutable std::vector<MatLayout> m_layouts;
+};
+
+#endif // SARCOS_CACHEDMAT_H
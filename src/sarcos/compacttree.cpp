@@ -0,0 +1,254 @@
+/// @file src/sarcos/compacttree.cpp
+
+#include "sarcos/compacttree.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    /// largest quantized magnitude, symmetric around 0
+    const int kMaxQuantized = 32767;
+
+    /// elements of a matrix, column major
+    inline const double* elements(const Mat33& mat) { return &mat.col[0].x; }
+    inline double* elements(Mat33& mat) { return &mat.col[0].x; }
+
+    /**
+     * @brief quantize 9 values to 16 bit integers
+     *
+     * @param values - finite values
+     * @param quantized - output, values / scale rounded to the nearest integer
+     * @return double - scale, the largest magnitude / kMaxQuantized
+     */
+    double quantize(const double* values, int16_t* quantized)
+    {
+        double maxAbs = 0;
+        for (int k=0; k<9; k++)
+        {
+            if (!std::isfinite(values[k]))
+            {
+                throw invalid_argument("quantized storage needs finite values");
+            }
+            maxAbs = max(maxAbs, fabs(values[k]));
+        }
+
+        // below the normal range the scale would round to 0: values round to 0 or +-maxAbs
+        double scale = maxAbs / kMaxQuantized;
+        if (scale == 0)
+        {
+            scale = maxAbs;
+        }
+        for (int k=0; k<9; k++)
+        {
+            long q = scale > 0 ? lround(values[k] / scale) : 0;
+            quantized[k] = int16_t(max(-long(kMaxQuantized), min(long(kMaxQuantized), q)));
+        }
+        return scale;
+    }
+}
+
+const CompactTree::Index CompactTree::kNoNode;
+
+MemoryFootprint footprintOf(const Node* root, size_t count)
+{
+    checkTree(root, count);
+    MemoryFootprint footprint;
+    footprint.numNodes = count;
+    footprint.numMatrices = footprint.numNodes;
+    footprint.matrixBytes = footprint.numNodes * sizeof(Mat33);
+    footprint.structureBytes = footprint.numNodes * (sizeof(Node) - sizeof(Mat33));
+    return footprint;
+}
+
+CompactTree::CompactTree(const Node* root, size_t count, const CompactTreeOptions& options)
+: m_options(options)
+, m_numMatrices(0)
+{
+    checkTree(root, count);
+    if (count >= kNoNode)
+    {
+        throw invalid_argument("tree too large for 32 bit indices");
+    }
+
+    // at most one matrix per node
+    switch (options.storage)
+    {
+    case MatStorage::Double:
+        m_doubles.reserve(count);
+        break;
+    case MatStorage::Float:
+        m_floats.reserve(9 * count);
+        break;
+    case MatStorage::Quantized16:
+        m_quantized.reserve(9 * count);
+        m_scales.reserve(count);
+        break;
+    }
+
+    unordered_map<string, Index> stored;
+    m_numChildren.resize(count);
+    m_matrices.resize(options.deduplicate ? count : 0);
+    for (size_t i=0; i<count; i++)
+    {
+        m_numChildren[i] = root[i].numChildren;
+        if (options.deduplicate)
+        {
+            m_matrices[i] = storeMatrix(root[i].data, &stored);
+        }
+        else
+        {
+            storeMatrix(root[i].data, nullptr);
+        }
+    }
+
+    // release the spare capacity of the pools, fewer matrices when deduplicated
+    m_doubles.shrink_to_fit();
+    m_floats.shrink_to_fit();
+    m_quantized.shrink_to_fit();
+    m_scales.shrink_to_fit();
+}
+
+size_t CompactTree::size() const
+{
+    return m_numChildren.size();
+}
+
+CompactTree::Index CompactTree::firstChild(Index index) const
+{
+    checkIndex(index);
+    return m_numChildren[index] ? index + 1 : kNoNode;
+}
+
+CompactTree::Index CompactTree::numChildren(Index index) const
+{
+    checkIndex(index);
+    return m_numChildren[index];
+}
+
+Mat33 CompactTree::data(Index index) const
+{
+    checkIndex(index);
+    const size_t m = m_matrices.empty() ? index : m_matrices[index];
+
+    Mat33 mat;
+    double* values = elements(mat);
+    switch (m_options.storage)
+    {
+    case MatStorage::Double:
+        mat = m_doubles[m];
+        break;
+    case MatStorage::Float:
+        for (int k=0; k<9; k++)
+        {
+            values[k] = m_floats[9*m + k];
+        }
+        break;
+    case MatStorage::Quantized16:
+        for (int k=0; k<9; k++)
+        {
+            values[k] = m_quantized[9*m + k] * m_scales[m];
+        }
+        break;
+    }
+    return mat;
+}
+
+const CompactTreeOptions& CompactTree::options() const
+{
+    return m_options;
+}
+
+MemoryFootprint CompactTree::footprint() const
+{
+    MemoryFootprint footprint;
+    footprint.numNodes = m_numChildren.size();
+    footprint.numMatrices = m_numMatrices;
+    footprint.structureBytes = (m_numChildren.size() + m_matrices.size()) * sizeof(Index);
+    footprint.matrixBytes = m_doubles.size() * sizeof(Mat33)
+                          + m_floats.size() * sizeof(float)
+                          + m_quantized.size() * sizeof(int16_t)
+                          + m_scales.size() * sizeof(double);
+    return footprint;
+}
+
+Node* CompactTree::toTree(unsigned int threads) const
+{
+    // direct children: from the first child, each next sibling follows the subtree of the previous one
+    vector<unsigned int> childCounts(size(), 0);
+    vector<Mat33> data(size());
+    for (size_t i=0; i<size(); i++)
+    {
+        const size_t end = i + m_numChildren[i];
+        for (size_t child = i + 1; child <= end; child += 1 + m_numChildren[child])
+        {
+            childCounts[i]++;
+        }
+        data[i] = this->data(Index(i));
+    }
+    return buildTreeFromChildCounts(data.data(), childCounts.data(), data.size(), threads);
+}
+
+CompactTree::Index CompactTree::storeMatrix(const Mat33& mat, unordered_map<string, Index>* stored)
+{
+    const double* values = elements(mat);
+
+    // convert to the storage, the stored bytes are the deduplication key
+    float floats[9];
+    int16_t quantized[9];
+    double scale = 0;
+    string key;
+    switch (m_options.storage)
+    {
+    case MatStorage::Double:
+        key.assign(reinterpret_cast<const char*>(values), 9 * sizeof(double));
+        break;
+    case MatStorage::Float:
+        for (int k=0; k<9; k++)
+        {
+            floats[k] = float(values[k]);
+        }
+        key.assign(reinterpret_cast<const char*>(floats), sizeof(floats));
+        break;
+    case MatStorage::Quantized16:
+        scale = quantize(values, quantized);
+        key.assign(reinterpret_cast<const char*>(quantized), sizeof(quantized));
+        key.append(reinterpret_cast<const char*>(&scale), sizeof(scale));
+        break;
+    }
+
+    if (stored)
+    {
+        auto inserted = stored->emplace(move(key), m_numMatrices);
+        if (!inserted.second)
+        {
+            return inserted.first->second;
+        }
+    }
+
+    switch (m_options.storage)
+    {
+    case MatStorage::Double:
+        m_doubles.push_back(mat);
+        break;
+    case MatStorage::Float:
+        m_floats.insert(m_floats.end(), floats, floats + 9);
+        break;
+    case MatStorage::Quantized16:
+        m_quantized.insert(m_quantized.end(), quantized, quantized + 9);
+        m_scales.push_back(scale);
+        break;
+    }
+    return m_numMatrices++;
+}
+
+void CompactTree::checkIndex(Index index) const
+{
+    if (index >= m_numChildren.size())
+    {
+        throw out_of_range("node index out of range");
+    }
+}
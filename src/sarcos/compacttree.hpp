@@ -0,0 +1,199 @@
+/// @file src/sarcos/compacttree.hpp
+
+#ifndef SARCOS_COMPACTTREE_H
+#define SARCOS_COMPACTTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sarcos/math.hpp"
+
+/**
+ * @brief storage of the matrices of a CompactTree
+ *
+ */
+enum class MatStorage
+{
+    /// 9 doubles, exact (72 bytes)
+    Double,
+
+    /// 9 floats, about 7 significant digits; magnitudes beyond float overflow to infinity (36 bytes)
+    Float,
+
+    /// 9 signed 16 bit integers and a double scale per matrix, absolute error up to
+    /// the largest magnitude of the matrix / 65534; finite values only (26 bytes)
+    Quantized16
+};
+
+/**
+ * @brief settings of a CompactTree
+ *
+ */
+struct CompactTreeOptions
+{
+    /// matrix storage
+    MatStorage storage = MatStorage::Double;
+
+    /// store identical matrices (after conversion to the storage) once
+    bool deduplicate = false;
+};
+
+/**
+ * @brief memory used by a tree representation
+ *
+ * Counts the bytes of the node and matrix arrays, not the allocator overhead.
+ */
+struct MemoryFootprint
+{
+    /// number of nodes
+    size_t numNodes = 0;
+
+    /// number of stored matrices, fewer than numNodes when deduplicated
+    size_t numMatrices = 0;
+
+    /// bytes of the node structure: links, counts, matrix indices
+    size_t structureBytes = 0;
+
+    /// bytes of the matrices, including their scales
+    size_t matrixBytes = 0;
+
+    /// total bytes
+    size_t totalBytes() const { return structureBytes + matrixBytes; }
+
+    /// average bytes per node
+    double bytesPerNode() const { return numNodes ? double(totalBytes()) / numNodes : 0.0; }
+};
+
+/**
+ * @brief footprint of a tree of Node, built in one allocation
+ *
+ * Throws std::invalid_argument if validateTree() rejects the tree.
+ *
+ * @param root - root of a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+ * @param count - number of nodes
+ * @return MemoryFootprint - sizeof(Node) per node, the data counted as matrix bytes
+ */
+MemoryFootprint footprintOf(const Node* root, size_t count);
+
+/**
+ * @brief Read-only copy of a Node tree in a compact format
+ *
+ * Nodes keep the preorder of the source tree, so the first child of a node
+ * is the next node and only the number of descendants is stored, 4 bytes
+ * per node. The matrices are stored in a separate pool, as doubles, floats
+ * or 16 bit integers with a per-matrix scale: matrix i is the data of node
+ * i, unless deduplicated, which adds a 32 bit matrix index per node.
+ *
+ * Holds up to 2^32 - 1 nodes.
+ */
+class CompactTree
+{
+public:
+    /// index of a node or of a matrix
+    typedef uint32_t Index;
+
+    /// no node, e.g. the first child of a leaf
+    static const Index kNoNode = ~0u;
+
+    /**
+     * @brief Construct from a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+     *
+     * Throws std::invalid_argument if validateTree() rejects the tree, or if
+     * Quantized16 storage meets a NaN or infinite value.
+     *
+     * @param root - root of the tree, followed by the rest of its nodes in preorder
+     * @param count - number of nodes
+     * @param options - matrix storage and deduplication
+     */
+    CompactTree(const Node* root, size_t count, const CompactTreeOptions& options = CompactTreeOptions());
+
+    /**
+     * @brief get the number of nodes
+     *
+     * @return size_t
+     */
+    size_t size() const;
+
+    /**
+     * @brief get the first child of a node, the next node in preorder
+     *
+     * @param index - preorder index of the node
+     * @return Index - kNoNode for a leaf
+     */
+    Index firstChild(Index index) const;
+
+    /**
+     * @brief get the number of descendants of a node, as Node::numChildren
+     *
+     * @param index - preorder index of the node
+     * @return Index
+     */
+    Index numChildren(Index index) const;
+
+    /**
+     * @brief get the data of a node, converted back to doubles
+     *
+     * @param index - preorder index of the node
+     * @return Mat33
+     */
+    Mat33 data(Index index) const;
+
+    /**
+     * @brief get the storage settings
+     *
+     * @return const CompactTreeOptions&
+     */
+    const CompactTreeOptions& options() const;
+
+    /**
+     * @brief get the memory used by this tree
+     *
+     * @return MemoryFootprint
+     */
+    MemoryFootprint footprint() const;
+
+    /**
+     * @brief expand back to a tree of Node, with the converted data
+     *
+     * @param threads - number of threads, 0 for one per hardware thread
+     * @return Node* - root of the tree, release with destroyTree()
+     */
+    Node* toTree(unsigned int threads = 0) const;
+
+private:
+    /**
+     * @brief store a matrix in the pool, or find an identical stored one
+     *
+     * @param mat - matrix
+     * @param stored - stored matrices by their bytes, nullptr to store every matrix
+     * @return Index - index of the matrix in the pool
+     */
+    Index storeMatrix(const Mat33& mat, std::unordered_map<std::string, Index>* stored);
+
+    /**
+     * @brief throw std::out_of_range unless index is a node of the tree
+     *
+     */
+    void checkIndex(Index index) const;
+
+    CompactTreeOptions m_options;
+
+    /// number of descendants of each node, as Node::numChildren
+    std::vector<Index> m_numChildren;
+
+    /// matrix of each node when deduplicated, empty otherwise (node i has matrix i)
+    std::vector<Index> m_matrices;
+
+    /// matrix pools, only the one of the storage is used
+    std::vector<Mat33> m_doubles;
+    std::vector<float> m_floats;
+    std::vector<int16_t> m_quantized;
+    std::vector<double> m_scales;
+
+    /// number of stored matrices
+    Index m_numMatrices;
+};
+
+#endif // SARCOS_COMPACTTREE_H
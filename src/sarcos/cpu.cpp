@@ -0,0 +1,79 @@
+/// @file src/sarcos/cpu.cpp
+
+#include "sarcos/cpu.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+SimdLevel detectSimdLevel()
+{
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    // also checks that the OS saves the wider registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+SimdLevel activeSimdLevel()
+{
+    // optionally forced lower, e.g. to compare or to reproduce results on other hosts
+    static const SimdLevel level = resolveSimdLevel(detectSimdLevel(), std::getenv("SARCOS_SIMD_LEVEL"), std::cerr);
+    return level;
+}
+
+SimdLevel resolveSimdLevel(SimdLevel hostLevel, const char* name, std::ostream& warnings)
+{
+    if (!name)
+    {
+        return hostLevel;
+    }
+    SimdLevel forcedLevel;
+    if (!parseSimdLevel(name, forcedLevel))
+    {
+        warnings << "warning: ignoring unknown SARCOS_SIMD_LEVEL \"" << name
+                 << "\", expected scalar, sse2, avx2 or avx512" << std::endl;
+        return hostLevel;
+    }
+    return forcedLevel < hostLevel ? forcedLevel : hostLevel;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::SSE2:
+            return "sse2";
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+bool parseSimdLevel(const char* name, SimdLevel& level)
+{
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel candidate : levels)
+    {
+        if (std::strcmp(name, simdLevelName(candidate)) == 0)
+        {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
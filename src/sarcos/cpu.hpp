@@ -0,0 +1,67 @@
+/// @file src/sarcos/cpu.hpp
+
+#ifndef SARCOS_CPU_H
+#define SARCOS_CPU_H
+
+#include <ostream>
+
+/**
+ * @brief SIMD instruction set levels the math kernels are built for
+ * 
+ * Ordered, each level implies the ones before it.
+ */
+enum class SimdLevel
+{
+    Scalar = 0,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief highest SIMD level supported by the host CPU (and OS)
+ * 
+ * @return SimdLevel 
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief SIMD level used by the dispatched math kernels
+ * 
+ * Resolved once, on first use: the host level, lowered to the level named by
+ * the SARCOS_SIMD_LEVEL environment variable (scalar, sse2, avx2 or avx512)
+ * if set. A level above what the host supports falls back to the host level,
+ * an unknown name is reported on standard error and ignored.
+ * 
+ * @return SimdLevel 
+ */
+SimdLevel activeSimdLevel();
+
+/**
+ * @brief host level, lowered to a forced level, as activeSimdLevel() resolves it
+ * 
+ * @param hostLevel - level supported by the host
+ * @param name - forced level name, nullptr if none
+ * @param warnings - output, a warning when the name is unknown
+ * @return SimdLevel 
+ */
+SimdLevel resolveSimdLevel(SimdLevel hostLevel, const char* name, std::ostream& warnings);
+
+/**
+ * @brief name of a SIMD level, as accepted by SARCOS_SIMD_LEVEL
+ * 
+ * @param level - SIMD level
+ * @return const char* 
+ */
+const char* simdLevelName(SimdLevel level);
+
+/**
+ * @brief parse the name of a SIMD level (case sensitive)
+ * 
+ * @param name - scalar, sse2, avx2 or avx512
+ * @param level - output, set when the name is valid
+ * @return true if the name is valid
+ */
+bool parseSimdLevel(const char* name, SimdLevel& level);
+
+#endif // SARCOS_CPU_H
@@ -1,6 +1,7 @@
 /// @file src/sarcos/math.cpp
 
 #include "sarcos/math.hpp"
+#include "sarcos/math_kernels.hpp"
 #include <algorithm>
 
 using namespace std;
@@ -32,4 +33,39 @@ Mat33 copyMat(const Mat33& mat)
         matCopy.col[c].z = mat.col[c].z;
     }
     return matCopy;
-}
\ No newline at end of file
+}
+
+Mat33 multiplyMat(const Mat33& mat1, const Mat33& mat2)
+{
+    // column c of the product combines the columns of mat1,
+    // weighted by the elements of column c of mat2
+    Mat33 result;
+    for (int c=0; c<3; c++)
+    {
+        const Vec3& w = mat2.col[c];
+        result.col[c].x = (mat1.col[0].x * w.x + mat1.col[1].x * w.y) + mat1.col[2].x * w.z;
+        result.col[c].y = (mat1.col[0].y * w.x + mat1.col[1].y * w.y) + mat1.col[2].y * w.z;
+        result.col[c].z = (mat1.col[0].z * w.x + mat1.col[1].z * w.y) + mat1.col[2].z * w.z;
+    }
+    return result;
+}
+
+void dotProducts(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count)
+{
+    activeMathKernels().dotProducts(vecs1, vecs2, results, count);
+}
+
+void transposeMats(Mat33* mats, size_t count)
+{
+    activeMathKernels().transposeMats(mats, count);
+}
+
+void copyMats(const Mat33* src, Mat33* dst, size_t count)
+{
+    activeMathKernels().copyMats(src, dst, count);
+}
+
+void multiplyMats(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count)
+{
+    activeMathKernels().multiplyMats(mats1, mats2, results, count);
+}
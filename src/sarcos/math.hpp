@@ -3,6 +3,8 @@
 #ifndef SARCOS_MATH_H
 #define SARCOS_MATH_H
 
+#include <cstddef>
+
 /**
  * @brief 3D vector
  * 
@@ -69,4 +71,60 @@ void transposeMat(Mat33& mat);
  */
 Mat33 copyMat(const Mat33& mat);
 
+/**
+ * @brief matrix product
+ * 
+ * @param mat1 - left matrix
+ * @param mat2 - right matrix
+ * @return Mat33 - mat1 * mat2
+ */
+Mat33 multiplyMat(const Mat33& mat1, const Mat33& mat2);
+
+/**
+ * @brief dot products of many pairs of vectors
+ * 
+ * Uses the SIMD kernels of the host CPU, see activeSimdLevel().
+ * Results are identical to calling dotProduct() on each pair.
+ * 
+ * @param vecs1 - first vector of each pair
+ * @param vecs2 - second vector of each pair
+ * @param results - output, results[i] = dot(vecs1[i], vecs2[i])
+ * @param count - number of pairs
+ */
+void dotProducts(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count);
+
+/**
+ * @brief transpose many matrices (in place)
+ * 
+ * Uses the SIMD kernels of the host CPU, see activeSimdLevel().
+ * 
+ * @param mats - matrices
+ * @param count - number of matrices
+ */
+void transposeMats(Mat33* mats, size_t count);
+
+/**
+ * @brief deep copy of many matrices
+ * 
+ * Uses the SIMD kernels of the host CPU, see activeSimdLevel().
+ * 
+ * @param src - matrices to copy
+ * @param dst - output, must not overlap src
+ * @param count - number of matrices
+ */
+void copyMats(const Mat33* src, Mat33* dst, size_t count);
+
+/**
+ * @brief matrix products of many pairs of matrices
+ * 
+ * Uses the SIMD kernels of the host CPU, see activeSimdLevel().
+ * Results are identical to calling multiplyMat() on each pair.
+ * 
+ * @param mats1 - left matrix of each pair
+ * @param mats2 - right matrix of each pair
+ * @param results - output, results[i] = mats1[i] * mats2[i] (may be mats1 or mats2)
+ * @param count - number of pairs
+ */
+void multiplyMats(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count);
+
 #endif // SARCOS_MATH_H
\ No newline at end of file
@@ -0,0 +1,362 @@
+/// @file src/sarcos/math_kernels.cpp
+///
+/// Built with -ffp-contract=off (see CMakeLists.txt) so that no variant,
+/// scalar or SIMD, fuses a multiply and an add: all of them round alike.
+
+#include "sarcos/math_kernels.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SARCOS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// the kernels address vectors and matrices as contiguous doubles
+static_assert(sizeof(Vec3) == 3 * sizeof(double), "Vec3 must not be padded");
+static_assert(sizeof(Mat33) == 9 * sizeof(double), "Mat33 must not be padded");
+
+namespace
+{
+    /// first element of an array of records, which may be empty and null: no member access
+    inline const double* elementsOf(const Vec3* vecs) { return reinterpret_cast<const double*>(vecs); }
+    inline const double* elementsOf(const Mat33* mats) { return reinterpret_cast<const double*>(mats); }
+    inline double* elementsOf(Mat33* mats) { return reinterpret_cast<double*>(mats); }
+
+    // ------------------------------------------------------------------
+    // scalar reference
+    // ------------------------------------------------------------------
+
+    void dotProductsScalar(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            results[i] = dotProduct(vecs1[i], vecs2[i]);
+        }
+    }
+
+    void transposeMatsScalar(Mat33* mats, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            transposeMat(mats[i]);
+        }
+    }
+
+    void copyMatsScalar(const Mat33* src, Mat33* dst, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            dst[i] = copyMat(src[i]);
+        }
+    }
+
+    void multiplyMatsScalar(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            results[i] = multiplyMat(mats1[i], mats2[i]);
+        }
+    }
+
+    /**
+     * @brief add up consecutive triples of products, in the scalar order (x + y) + z
+     *
+     * @param products - 3 * count products
+     * @param results - output, count sums
+     * @param count - number of triples
+     */
+    inline void sumTriples(const double* products, double* results, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            results[i] = (products[3*i] + products[3*i + 1]) + products[3*i + 2];
+        }
+    }
+
+#ifdef SARCOS_X86_KERNELS
+
+    // ------------------------------------------------------------------
+    // SSE2, 2 doubles per register
+    // ------------------------------------------------------------------
+
+    __attribute__((target("sse2")))
+    void dotProductsSSE2(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count)
+    {
+        const double* a = elementsOf(vecs1);
+        const double* b = elementsOf(vecs2);
+        size_t i = 0;
+
+        // 2 pairs of vectors (6 doubles) per iteration
+        for (; i + 2 <= count; i += 2)
+        {
+            double products[6];
+            for (int k=0; k<6; k+=2)
+            {
+                _mm_storeu_pd(products + k, _mm_mul_pd(_mm_loadu_pd(a + 3*i + k), _mm_loadu_pd(b + 3*i + k)));
+            }
+            sumTriples(products, results + i, 2);
+        }
+        dotProductsScalar(vecs1 + i, vecs2 + i, results + i, count - i);
+    }
+
+    __attribute__((target("sse2")))
+    void transposeMatsSSE2(Mat33* mats, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            double* m = &mats[i].col[0].x;
+            __m128d m01 = _mm_loadu_pd(m);
+            __m128d m23 = _mm_loadu_pd(m + 2);
+            __m128d m45 = _mm_loadu_pd(m + 4);
+            __m128d m67 = _mm_loadu_pd(m + 6);
+
+            // [m0 m3] [m6 m1] [m4 m7] [m2 m5], m8 stays in place
+            _mm_storeu_pd(m,     _mm_shuffle_pd(m01, m23, 2));
+            _mm_storeu_pd(m + 2, _mm_shuffle_pd(m67, m01, 2));
+            _mm_storeu_pd(m + 4, _mm_shuffle_pd(m45, m67, 2));
+            _mm_storeu_pd(m + 6, _mm_shuffle_pd(m23, m45, 2));
+        }
+    }
+
+    __attribute__((target("sse2")))
+    void copyMatsSSE2(const Mat33* src, Mat33* dst, size_t count)
+    {
+        const double* s = elementsOf(src);
+        double* d = elementsOf(dst);
+        const size_t n = 9 * count;
+        size_t k = 0;
+        for (; k + 2 <= n; k += 2)
+        {
+            _mm_storeu_pd(d + k, _mm_loadu_pd(s + k));
+        }
+        for (; k < n; k++)
+        {
+            d[k] = s[k];
+        }
+    }
+
+    __attribute__((target("sse2")))
+    void multiplyMatsSSE2(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            const double* a = &mats1[i].col[0].x;
+            const double* b = &mats2[i].col[0].x;
+            double* c = &results[i].col[0].x;
+
+            // x,y of each column of mats1 in a register, z as a scalar
+            const __m128d a0 = _mm_loadu_pd(a);
+            const __m128d a1 = _mm_loadu_pd(a + 3);
+            const __m128d a2 = _mm_loadu_pd(a + 6);
+            const double a0z = a[2], a1z = a[5], a2z = a[8];
+
+            for (int j=0; j<3; j++)
+            {
+                const double bx = b[3*j], by = b[3*j + 1], bz = b[3*j + 2];
+                __m128d xy = _mm_mul_pd(a0, _mm_set1_pd(bx));
+                xy = _mm_add_pd(xy, _mm_mul_pd(a1, _mm_set1_pd(by)));
+                xy = _mm_add_pd(xy, _mm_mul_pd(a2, _mm_set1_pd(bz)));
+                const double z = (a0z * bx + a1z * by) + a2z * bz;
+                _mm_storeu_pd(c + 3*j, xy);
+                c[3*j + 2] = z;
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // AVX2, 4 doubles per register
+    // ------------------------------------------------------------------
+
+    __attribute__((target("avx2")))
+    void dotProductsAVX2(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count)
+    {
+        const double* a = elementsOf(vecs1);
+        const double* b = elementsOf(vecs2);
+        size_t i = 0;
+
+        // 4 pairs of vectors (12 doubles) per iteration
+        for (; i + 4 <= count; i += 4)
+        {
+            double products[12];
+            for (int k=0; k<12; k+=4)
+            {
+                _mm256_storeu_pd(products + k, _mm256_mul_pd(_mm256_loadu_pd(a + 3*i + k), _mm256_loadu_pd(b + 3*i + k)));
+            }
+            sumTriples(products, results + i, 4);
+        }
+        dotProductsSSE2(vecs1 + i, vecs2 + i, results + i, count - i);
+    }
+
+    __attribute__((target("avx2")))
+    void transposeMatsAVX2(Mat33* mats, size_t count)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            double* m = &mats[i].col[0].x;
+
+            // [m0 m3 m2 m1] and [m4 m7 m6 m5]
+            const __m256d lo = _mm256_permute4x64_pd(_mm256_loadu_pd(m), 0x6C);
+            const __m256d hi = _mm256_permute4x64_pd(_mm256_loadu_pd(m + 4), 0x6C);
+
+            // [m0 m3 m6 m1] [m4 m7 m2 m5], m8 stays in place
+            _mm256_storeu_pd(m,     _mm256_blend_pd(lo, hi, 0x4));
+            _mm256_storeu_pd(m + 4, _mm256_blend_pd(hi, lo, 0x4));
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void copyMatsAVX2(const Mat33* src, Mat33* dst, size_t count)
+    {
+        const double* s = elementsOf(src);
+        double* d = elementsOf(dst);
+        const size_t n = 9 * count;
+        size_t k = 0;
+        for (; k + 4 <= n; k += 4)
+        {
+            _mm256_storeu_pd(d + k, _mm256_loadu_pd(s + k));
+        }
+        for (; k < n; k++)
+        {
+            d[k] = s[k];
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void multiplyMatsAVX2(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count)
+    {
+        // only the 3 doubles of a column are loaded and stored
+        const __m256i mask = _mm256_set_epi64x(0, -1, -1, -1);
+
+        for (size_t i=0; i<count; i++)
+        {
+            const double* a = &mats1[i].col[0].x;
+            const double* b = &mats2[i].col[0].x;
+            double* c = &results[i].col[0].x;
+
+            const __m256d a0 = _mm256_maskload_pd(a, mask);
+            const __m256d a1 = _mm256_maskload_pd(a + 3, mask);
+            const __m256d a2 = _mm256_maskload_pd(a + 6, mask);
+
+            for (int j=0; j<3; j++)
+            {
+                __m256d col = _mm256_mul_pd(a0, _mm256_set1_pd(b[3*j]));
+                col = _mm256_add_pd(col, _mm256_mul_pd(a1, _mm256_set1_pd(b[3*j + 1])));
+                col = _mm256_add_pd(col, _mm256_mul_pd(a2, _mm256_set1_pd(b[3*j + 2])));
+                _mm256_maskstore_pd(c + 3*j, mask, col);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // AVX-512, 8 doubles per register
+    // ------------------------------------------------------------------
+
+    __attribute__((target("avx512f")))
+    void dotProductsAVX512(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count)
+    {
+        const double* a = elementsOf(vecs1);
+        const double* b = elementsOf(vecs2);
+        size_t i = 0;
+
+        // 8 pairs of vectors (24 doubles) per iteration
+        for (; i + 8 <= count; i += 8)
+        {
+            double products[24];
+            for (int k=0; k<24; k+=8)
+            {
+                _mm512_storeu_pd(products + k, _mm512_mul_pd(_mm512_loadu_pd(a + 3*i + k), _mm512_loadu_pd(b + 3*i + k)));
+            }
+            sumTriples(products, results + i, 8);
+        }
+        dotProductsAVX2(vecs1 + i, vecs2 + i, results + i, count - i);
+    }
+
+    __attribute__((target("avx512f")))
+    void transposeMatsAVX512(Mat33* mats, size_t count)
+    {
+        // [m0 m3 m6 m1 m4 m7 m2 m5], m8 stays in place
+        const __m512i index = _mm512_set_epi64(5, 2, 7, 4, 1, 6, 3, 0);
+
+        for (size_t i=0; i<count; i++)
+        {
+            double* m = &mats[i].col[0].x;
+            _mm512_storeu_pd(m, _mm512_permutexvar_pd(index, _mm512_loadu_pd(m)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void copyMatsAVX512(const Mat33* src, Mat33* dst, size_t count)
+    {
+        const double* s = elementsOf(src);
+        double* d = elementsOf(dst);
+        const size_t n = 9 * count;
+        size_t k = 0;
+        for (; k + 8 <= n; k += 8)
+        {
+            _mm512_storeu_pd(d + k, _mm512_loadu_pd(s + k));
+        }
+        for (; k < n; k++)
+        {
+            d[k] = s[k];
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void multiplyMatsAVX512(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count)
+    {
+        // only the 3 doubles of a column are loaded and stored
+        const __mmask8 mask = 0x07;
+
+        for (size_t i=0; i<count; i++)
+        {
+            const double* a = &mats1[i].col[0].x;
+            const double* b = &mats2[i].col[0].x;
+            double* c = &results[i].col[0].x;
+
+            const __m512d a0 = _mm512_maskz_loadu_pd(mask, a);
+            const __m512d a1 = _mm512_maskz_loadu_pd(mask, a + 3);
+            const __m512d a2 = _mm512_maskz_loadu_pd(mask, a + 6);
+
+            for (int j=0; j<3; j++)
+            {
+                __m512d col = _mm512_mul_pd(a0, _mm512_set1_pd(b[3*j]));
+                col = _mm512_add_pd(col, _mm512_mul_pd(a1, _mm512_set1_pd(b[3*j + 1])));
+                col = _mm512_add_pd(col, _mm512_mul_pd(a2, _mm512_set1_pd(b[3*j + 2])));
+                _mm512_mask_storeu_pd(c + 3*j, mask, col);
+            }
+        }
+    }
+
+#endif // SARCOS_X86_KERNELS
+
+    const MathKernels kScalarKernels = {dotProductsScalar, transposeMatsScalar, copyMatsScalar, multiplyMatsScalar};
+
+#ifdef SARCOS_X86_KERNELS
+    const MathKernels kSSE2Kernels = {dotProductsSSE2, transposeMatsSSE2, copyMatsSSE2, multiplyMatsSSE2};
+    const MathKernels kAVX2Kernels = {dotProductsAVX2, transposeMatsAVX2, copyMatsAVX2, multiplyMatsAVX2};
+    const MathKernels kAVX512Kernels = {dotProductsAVX512, transposeMatsAVX512, copyMatsAVX512, multiplyMatsAVX512};
+#endif
+}
+
+const MathKernels& mathKernels(SimdLevel level)
+{
+#ifdef SARCOS_X86_KERNELS
+    switch (level)
+    {
+        case SimdLevel::SSE2:
+            return kSSE2Kernels;
+        case SimdLevel::AVX2:
+            return kAVX2Kernels;
+        case SimdLevel::AVX512:
+            return kAVX512Kernels;
+        default:
+            break;
+    }
+#endif
+    return kScalarKernels;
+}
+
+const MathKernels& activeMathKernels()
+{
+    static const MathKernels& kernels = mathKernels(activeSimdLevel());
+    return kernels;
+}
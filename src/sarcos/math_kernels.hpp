@@ -0,0 +1,51 @@
+/// @file src/sarcos/math_kernels.hpp
+
+#ifndef SARCOS_MATH_KERNELS_H
+#define SARCOS_MATH_KERNELS_H
+
+#include <cstddef>
+#include "sarcos/cpu.hpp"
+#include "sarcos/math.hpp"
+
+/**
+ * @brief table of batch math kernels built for one SIMD level
+ * 
+ * Every variant gives bit-identical results to the scalar kernels:
+ * products and sums are evaluated in the same order, without fused multiply-add.
+ * 
+ * @see dotProducts(), transposeMats(), copyMats(), multiplyMats()
+ */
+struct MathKernels
+{
+    /// results[i] = dot(vecs1[i], vecs2[i])
+    void (*dotProducts)(const Vec3* vecs1, const Vec3* vecs2, double* results, size_t count);
+
+    /// transpose every matrix in place
+    void (*transposeMats)(Mat33* mats, size_t count);
+
+    /// dst[i] = src[i]
+    void (*copyMats)(const Mat33* src, Mat33* dst, size_t count);
+
+    /// results[i] = mats1[i] * mats2[i], results may alias mats1 or mats2
+    void (*multiplyMats)(const Mat33* mats1, const Mat33* mats2, Mat33* results, size_t count);
+};
+
+/**
+ * @brief kernels built for a given SIMD level
+ * 
+ * The level must be supported by the host, see detectSimdLevel().
+ * Levels not built for this architecture give the scalar kernels.
+ * 
+ * @param level - SIMD level
+ * @return const MathKernels& 
+ */
+const MathKernels& mathKernels(SimdLevel level);
+
+/**
+ * @brief kernels for activeSimdLevel(), resolved once on first use
+ * 
+ * @return const MathKernels& 
+ */
+const MathKernels& activeMathKernels();
+
+#endif // SARCOS_MATH_KERNELS_H
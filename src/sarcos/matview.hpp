@@ -0,0 +1,176 @@
+/// @file src/sarcos/matview.hpp
+
+#ifndef SARCOS_MATVIEW_H
+#define SARCOS_MATVIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include "sarcos/math.hpp"
+
+// the views below address a Mat33 as 9 contiguous doubles (column major)
+static_assert(sizeof(Vec3) == 3 * sizeof(double), "Vec3 must not be padded");
+static_assert(sizeof(Mat33) == 9 * sizeof(double), "Mat33 must not be padded");
+
+/**
+ * @brief random access iterator stepping over a Mat33 with a fixed stride
+ *
+ * stride 1 walks down a column, stride 3 walks across a row
+ */
+class MatStrideIterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = double;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const double*;
+    using reference = const double&;
+
+    /**
+     * @brief Construct a new iterator
+     *
+     * @param ptr - current element
+     * @param stride - distance (in doubles) between consecutive elements
+     */
+    MatStrideIterator(const double* ptr, int stride) : m_ptr(ptr), m_stride(stride) {}
+
+    reference operator*() const { return *m_ptr; }
+    pointer operator->() const { return m_ptr; }
+    reference operator[](difference_type n) const { return m_ptr[n * m_stride]; }
+
+    MatStrideIterator& operator++() { m_ptr += m_stride; return *this; }
+    MatStrideIterator operator++(int) { MatStrideIterator it = *this; ++(*this); return it; }
+    MatStrideIterator& operator--() { m_ptr -= m_stride; return *this; }
+    MatStrideIterator operator--(int) { MatStrideIterator it = *this; --(*this); return it; }
+    MatStrideIterator& operator+=(difference_type n) { m_ptr += n * m_stride; return *this; }
+    MatStrideIterator& operator-=(difference_type n) { m_ptr -= n * m_stride; return *this; }
+    MatStrideIterator operator+(difference_type n) const { return MatStrideIterator(m_ptr + n * m_stride, m_stride); }
+    MatStrideIterator operator-(difference_type n) const { return MatStrideIterator(m_ptr - n * m_stride, m_stride); }
+    difference_type operator-(const MatStrideIterator& other) const { return (m_ptr - other.m_ptr) / m_stride; }
+
+    bool operator==(const MatStrideIterator& other) const { return m_ptr == other.m_ptr; }
+    bool operator!=(const MatStrideIterator& other) const { return m_ptr != other.m_ptr; }
+    bool operator<(const MatStrideIterator& other) const { return m_ptr < other.m_ptr; }
+    bool operator>(const MatStrideIterator& other) const { return m_ptr > other.m_ptr; }
+    bool operator<=(const MatStrideIterator& other) const { return m_ptr <= other.m_ptr; }
+    bool operator>=(const MatStrideIterator& other) const { return m_ptr >= other.m_ptr; }
+
+private:
+    const double* m_ptr;
+    int m_stride;
+};
+
+/**
+ * @brief non-owning view of a single row or column of a Mat33
+ *
+ * Elements are read in place, nothing is copied.
+ * The viewed matrix must outlive the view.
+ */
+class MatLineView
+{
+public:
+    /**
+     * @brief Construct a new line view
+     *
+     * @param first - first element of the line
+     * @param stride - distance (in doubles) between elements of the line
+     */
+    MatLineView(const double* first, int stride) : m_first(first), m_stride(stride) {}
+
+    /**
+     * @brief element i of the line (0, 1 or 2)
+     *
+     * @param i - element index
+     * @return const double&
+     */
+    const double& operator[](int i) const { return m_first[i * m_stride]; }
+
+    /// number of elements in the line
+    static constexpr int size() { return 3; }
+
+    /// distance (in doubles) between elements of the line
+    int stride() const { return m_stride; }
+
+    MatStrideIterator begin() const { return MatStrideIterator(m_first, m_stride); }
+    MatStrideIterator end() const { return MatStrideIterator(m_first + 3 * m_stride, m_stride); }
+
+private:
+    const double* m_first;
+    int m_stride;
+};
+
+/**
+ * @brief non-owning (optionally transposed) view of a Mat33
+ *
+ * Gives row-major and column-major access to a matrix without
+ * copying or mutating it, e.g. the transpose of a const Mat33
+ * can be read directly through transposed().
+ * The viewed matrix must outlive the view.
+ */
+class MatView
+{
+public:
+    /**
+     * @brief Construct a view of a matrix
+     *
+     * @param mat - matrix
+     */
+    explicit MatView(const Mat33& mat) : m_data(&mat.col[0].x), m_transposed(false) {}
+
+    /**
+     * @brief element at (row, col), as seen through the view
+     *
+     * @param row - row index
+     * @param col - column index
+     * @return const double&
+     */
+    const double& operator()(int row, int col) const
+    {
+        return m_transposed ? m_data[3 * row + col] : m_data[3 * col + row];
+    }
+
+    /**
+     * @brief view of a row
+     *
+     * @param row - row index
+     * @return MatLineView
+     */
+    MatLineView row(int row) const
+    {
+        return m_transposed ? MatLineView(m_data + 3 * row, 1) : MatLineView(m_data + row, 3);
+    }
+
+    /**
+     * @brief view of a column
+     *
+     * @param col - column index
+     * @return MatLineView
+     */
+    MatLineView col(int col) const
+    {
+        return m_transposed ? MatLineView(m_data + col, 3) : MatLineView(m_data + 3 * col, 1);
+    }
+
+    /**
+     * @brief zero-copy transpose of this view
+     *
+     * @return MatView
+     */
+    MatView transposed() const
+    {
+        MatView view(*this);
+        view.m_transposed = !m_transposed;
+        return view;
+    }
+
+    /// true if the view presents the transpose of the underlying matrix
+    bool isTransposed() const { return m_transposed; }
+
+private:
+    /// first element of the viewed matrix
+    const double* m_data;
+
+    /// swap the meaning of rows and columns
+    bool m_transposed;
+};
+
+#endif // SARCOS_MATVIEW_H
@@ -0,0 +1,63 @@
+/// @file src/sarcos/parallel.hpp
+
+#ifndef SARCOS_PARALLEL_H
+#define SARCOS_PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief number of threads to run, given a requested count
+ * 
+ * @param requested - desired number of threads, 0 for one per hardware thread
+ * @return unsigned int - at least 1
+ */
+inline unsigned int resolveThreadCount(unsigned int requested)
+{
+    if (requested == 0)
+    {
+        requested = std::thread::hardware_concurrency();
+    }
+    return std::max(1u, requested);
+}
+
+/**
+ * @brief run func(begin, end) over [0, count), split in one contiguous range per thread
+ * 
+ * Each thread gets at least minChunk items, so small counts run
+ * on the calling thread alone. func must not throw.
+ * 
+ * @param count - number of items
+ * @param minChunk - smallest number of items worth a thread
+ * @param threads - number of threads, 0 for one per hardware thread
+ * @param func - called as func(size_t begin, size_t end)
+ */
+template <typename Func>
+void parallelFor(size_t count, size_t minChunk, unsigned int threads, Func func)
+{
+    const size_t numThreads = std::min<size_t>(resolveThreadCount(threads), count / std::max<size_t>(1, minChunk));
+    if (numThreads <= 1)
+    {
+        func(size_t(0), count);
+        return;
+    }
+
+    // the calling thread takes the first range
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads - 1);
+    const size_t chunk = (count + numThreads - 1) / numThreads;
+    for (size_t begin = chunk; begin < count; begin += chunk)
+    {
+        workers.emplace_back(func, begin, std::min(count, begin + chunk));
+    }
+    func(size_t(0), std::min(count, chunk));
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+#endif // SARCOS_PARALLEL_H
@@ -0,0 +1,63 @@
+/// @file src/sarcos/pipeline.cpp
+
+#include "sarcos/pipeline.hpp"
+#include "sarcos/parallel.hpp"
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int threads)
+: m_stop(false)
+{
+    const unsigned int count = resolveThreadCount(threads);
+    m_threads.reserve(count);
+    for (unsigned int i=0; i<count; i++)
+    {
+        m_threads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_ready.notify_all();
+    for (thread& worker : m_threads)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::post(coroutine_handle<> handle)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_queue.push_back(handle);
+    }
+    m_ready.notify_one();
+}
+
+unsigned int ThreadPool::size() const
+{
+    return m_threads.size();
+}
+
+void ThreadPool::work()
+{
+    for (;;)
+    {
+        coroutine_handle<> handle;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_ready.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty())
+            {
+                return;
+            }
+            handle = m_queue.front();
+            m_queue.pop_front();
+        }
+        handle.resume();
+    }
+}
@@ -0,0 +1,670 @@
+/// @file src/sarcos/pipeline.hpp
+
+#ifndef SARCOS_PIPELINE_H
+#define SARCOS_PIPELINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Coroutine pipeline: a source generator feeding a transform stage and
+ *        a sink stage through bounded channels, run on a small thread pool
+ *
+ * Stages are coroutines. A stage waiting on a full channel (backpressure) or
+ * an empty one suspends instead of blocking, and is resumed on the pool when
+ * the channel moves, so reading, computing and writing overlap on as few as
+ * one thread.
+ */
+
+/**
+ * @brief Fixed set of threads resuming coroutines
+ *
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start the threads
+     *
+     * @param threads - number of threads, 0 for one per hardware thread
+     */
+    explicit ThreadPool(unsigned int threads = 0);
+
+    /**
+     * @brief Resume the queued coroutines, then join the threads
+     *
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief queue a coroutine, resumed by the next free thread
+     *
+     * @param handle - suspended coroutine
+     */
+    void post(std::coroutine_handle<> handle);
+
+    /**
+     * @brief get the number of threads
+     *
+     * @return unsigned int
+     */
+    unsigned int size() const;
+
+private:
+    /**
+     * @brief resume queued coroutines until the pool stops
+     *
+     */
+    void work();
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<std::coroutine_handle<>> m_queue;
+    bool m_stop;
+    std::vector<std::thread> m_threads;
+};
+
+/**
+ * @brief Lazy sequence of values produced by a coroutine with co_yield
+ *
+ * The coroutine runs on the thread calling next(), up to its next co_yield.
+ */
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type
+    {
+        /// value of the last co_yield, alive while the coroutine is suspended there
+        T* value = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T& value) noexcept { this->value = &value; return {}; }
+        std::suspend_always yield_value(T&& value) noexcept { this->value = &value; return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    Generator(Generator&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    ~Generator()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+    /**
+     * @brief run the coroutine to its next co_yield
+     *
+     * Rethrows an exception escaping the coroutine.
+     *
+     * @return std::optional<T> - the yielded value (moved out), empty once the coroutine returned
+     */
+    std::optional<T> next()
+    {
+        if (m_handle.done())
+        {
+            return std::nullopt;
+        }
+        m_handle.resume();
+        if (m_handle.promise().exception)
+        {
+            std::rethrow_exception(std::exchange(m_handle.promise().exception, nullptr));
+        }
+        if (m_handle.done())
+        {
+            return std::nullopt;
+        }
+        return std::move(*m_handle.promise().value);
+    }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/**
+ * @brief Coroutine run on a ThreadPool, waited for from a regular thread
+ *
+ */
+class Task
+{
+public:
+    struct promise_type
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        std::exception_ptr exception;
+
+        /// signals the waiting thread once the coroutine is suspended for good
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+            {
+                promise_type& promise = handle.promise();
+                std::lock_guard<std::mutex> lock(promise.mutex);
+                promise.done = true;
+                promise.finished.notify_all();
+            }
+            void await_resume() noexcept {}
+        };
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+    , m_started(other.m_started)
+    {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    /**
+     * @brief Wait for a started coroutine, then release it
+     *
+     */
+    ~Task()
+    {
+        if (!m_handle)
+        {
+            return;
+        }
+        if (m_started)
+        {
+            waitDone();
+        }
+        m_handle.destroy();
+    }
+
+    /**
+     * @brief start the coroutine on a thread of the pool
+     *
+     * @param pool - thread pool
+     */
+    void start(ThreadPool& pool)
+    {
+        m_started = true;
+        pool.post(m_handle);
+    }
+
+    /**
+     * @brief wait for the coroutine to finish, rethrows an exception escaping it
+     *
+     */
+    void wait()
+    {
+        waitDone();
+        if (m_handle.promise().exception)
+        {
+            std::rethrow_exception(std::exchange(m_handle.promise().exception, nullptr));
+        }
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle), m_started(false) {}
+
+    void waitDone()
+    {
+        promise_type& promise = m_handle.promise();
+        std::unique_lock<std::mutex> lock(promise.mutex);
+        promise.finished.wait(lock, [&]() { return promise.done; });
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+    bool m_started;
+};
+
+/**
+ * @brief Bounded queue between coroutines
+ *
+ * co_await send(value) suspends the sender while the channel is full,
+ * co_await receive() suspends the receiver while it is empty. Suspended
+ * coroutines are resumed on the pool, never inside the call that woke them.
+ */
+template <typename T>
+class Channel
+{
+public:
+    /**
+     * @brief Construct an open, empty channel
+     *
+     * @param capacity - number of values held before senders wait, at least 1
+     * @param pool - pool resuming the waiting coroutines
+     */
+    Channel(size_t capacity, ThreadPool& pool)
+    : m_capacity(capacity)
+    , m_pool(pool)
+    , m_closed(false)
+    , m_sendWaits(0)
+    , m_receiveWaits(0)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("channel capacity must be at least 1");
+        }
+    }
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    /// awaiter of send(): true if the value was queued, false if the channel is closed
+    class SendAwaiter
+    {
+    public:
+        SendAwaiter(Channel& channel, T value) : m_channel(channel), m_value(std::move(value)), m_sent(false) {}
+
+        bool await_ready() { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::unique_lock<std::mutex> lock(m_channel.m_mutex);
+            if (m_channel.m_closed)
+            {
+                return false;
+            }
+            if (!m_channel.m_receivers.empty())
+            {
+                // hand the value to a waiting receiver
+                auto receiver = m_channel.m_receivers.front();
+                m_channel.m_receivers.pop_front();
+                receiver.second->m_value = std::move(m_value);
+                m_sent = true;
+                lock.unlock();
+                m_channel.m_pool.post(receiver.first);
+                return false;
+            }
+            if (m_channel.m_values.size() < m_channel.m_capacity)
+            {
+                m_channel.m_values.push_back(std::move(m_value));
+                m_sent = true;
+                return false;
+            }
+
+            // full: wait for a receiver to make room
+            m_channel.m_senders.emplace_back(handle, this);
+            m_channel.m_sendWaits++;
+            return true;
+        }
+
+        bool await_resume() { return m_sent; }
+
+    private:
+        friend class Channel;
+
+        Channel& m_channel;
+        T m_value;
+        bool m_sent;
+    };
+
+    /// awaiter of receive(): the next value, empty once the channel is closed and drained
+    class ReceiveAwaiter
+    {
+    public:
+        explicit ReceiveAwaiter(Channel& channel) : m_channel(channel) {}
+
+        bool await_ready() { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::unique_lock<std::mutex> lock(m_channel.m_mutex);
+            if (!m_channel.m_values.empty())
+            {
+                m_value = std::move(m_channel.m_values.front());
+                m_channel.m_values.pop_front();
+
+                // room for a waiting sender
+                if (!m_channel.m_senders.empty())
+                {
+                    auto sender = m_channel.m_senders.front();
+                    m_channel.m_senders.pop_front();
+                    m_channel.m_values.push_back(std::move(sender.second->m_value));
+                    sender.second->m_sent = true;
+                    lock.unlock();
+                    m_channel.m_pool.post(sender.first);
+                }
+                return false;
+            }
+            if (m_channel.m_closed)
+            {
+                return false;
+            }
+
+            // empty: wait for a sender
+            m_channel.m_receivers.emplace_back(handle, this);
+            m_channel.m_receiveWaits++;
+            return true;
+        }
+
+        std::optional<T> await_resume() { return std::move(m_value); }
+
+    private:
+        friend class Channel;
+
+        Channel& m_channel;
+        std::optional<T> m_value;
+    };
+
+    /**
+     * @brief queue a value, co_await the result
+     *
+     * @param value - value to send
+     * @return SendAwaiter - true if queued, false if the channel is closed
+     */
+    SendAwaiter send(T value) { return SendAwaiter(*this, std::move(value)); }
+
+    /**
+     * @brief take the next value, co_await the result
+     *
+     * @return ReceiveAwaiter - the value, empty once the channel is closed and drained
+     */
+    ReceiveAwaiter receive() { return ReceiveAwaiter(*this); }
+
+    /**
+     * @brief close the channel: sends fail, receives drain the queued values
+     *
+     * Waiting senders resume with false, waiting receivers with no value.
+     */
+    void close()
+    {
+        std::vector<std::coroutine_handle<>> waiting;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            for (auto& sender : m_senders)
+            {
+                waiting.push_back(sender.first);
+            }
+            for (auto& receiver : m_receivers)
+            {
+                waiting.push_back(receiver.first);
+            }
+            m_senders.clear();
+            m_receivers.clear();
+        }
+        for (std::coroutine_handle<> handle : waiting)
+        {
+            m_pool.post(handle);
+        }
+    }
+
+    /// number of times a sender waited on a full channel
+    uint64_t sendWaits() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_sendWaits;
+    }
+
+    /// number of times a receiver waited on an empty channel
+    uint64_t receiveWaits() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_receiveWaits;
+    }
+
+private:
+    const size_t m_capacity;
+    ThreadPool& m_pool;
+
+    mutable std::mutex m_mutex;
+    std::deque<T> m_values;
+    std::deque<std::pair<std::coroutine_handle<>, SendAwaiter*>> m_senders;
+    std::deque<std::pair<std::coroutine_handle<>, ReceiveAwaiter*>> m_receivers;
+    bool m_closed;
+    uint64_t m_sendWaits;
+    uint64_t m_receiveWaits;
+};
+
+/**
+ * @brief settings of runPipeline()
+ *
+ */
+struct PipelineOptions
+{
+    /// threads of the pool, 0 for one per hardware thread
+    unsigned int threads = 3;
+
+    /// batches held by each channel before the stage feeding it waits
+    size_t channelCapacity = 4;
+};
+
+/**
+ * @brief counters of one stage
+ *
+ */
+struct StageStats
+{
+    /// name of the stage
+    std::string name;
+
+    /// batches handled
+    uint64_t batches = 0;
+
+    /// items in those batches
+    uint64_t items = 0;
+
+    /// time spent in the stage work, excluding the waits on channels
+    double busySeconds = 0;
+
+    /// number of times the stage waited on a full output or an empty input channel
+    uint64_t waits = 0;
+
+    /// items per second of stage work
+    double itemsPerSecond() const { return busySeconds > 0 ? items / busySeconds : 0.0; }
+};
+
+/**
+ * @brief counters of a pipeline run
+ *
+ */
+struct PipelineStats
+{
+    /// read, transform and write stages
+    std::vector<StageStats> stages;
+
+    /// wall time of the run
+    double seconds = 0;
+};
+
+/**
+ * @brief source stage: pulls batches from the generator into the channel
+ *
+ */
+template <typename Batch>
+Task pipelineSourceStage(Generator<Batch>& source, Channel<Batch>& out, StageStats& stats)
+{
+    try
+    {
+        for (;;)
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            std::optional<Batch> batch = source.next();
+            stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            if (!batch)
+            {
+                break;
+            }
+            stats.batches++;
+            stats.items += batch->size();
+            if (!co_await out.send(std::move(*batch)))
+            {
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        out.close();
+        throw;
+    }
+    out.close();
+}
+
+/**
+ * @brief transform stage: applies transform(batch) to each batch, in order
+ *
+ */
+template <typename Batch, typename Transform>
+Task pipelineTransformStage(Channel<Batch>& in, Channel<Batch>& out, Transform& transform, StageStats& stats)
+{
+    try
+    {
+        for (;;)
+        {
+            std::optional<Batch> batch = co_await in.receive();
+            if (!batch)
+            {
+                break;
+            }
+            // the items received: transform may change what batch.size() counts
+            stats.batches++;
+            stats.items += batch->size();
+            const auto begin = std::chrono::steady_clock::now();
+            transform(*batch);
+            stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            if (!co_await out.send(std::move(*batch)))
+            {
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        // stop both neighbors
+        in.close();
+        out.close();
+        throw;
+    }
+    in.close();
+    out.close();
+}
+
+/**
+ * @brief sink stage: passes each batch to sink(batch), in order
+ *
+ */
+template <typename Batch, typename Sink>
+Task pipelineSinkStage(Channel<Batch>& in, Sink& sink, StageStats& stats)
+{
+    try
+    {
+        for (;;)
+        {
+            std::optional<Batch> batch = co_await in.receive();
+            if (!batch)
+            {
+                break;
+            }
+            const auto begin = std::chrono::steady_clock::now();
+            sink(*batch);
+            stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            stats.batches++;
+            stats.items += batch->size();
+        }
+    }
+    catch (...)
+    {
+        in.close();
+        throw;
+    }
+    in.close();
+}
+
+/**
+ * @brief run source -> transform -> sink with the stages overlapping on a thread pool
+ *
+ * Batches keep their order. Each stage runs on one thread at a time, so
+ * transform and sink need no locking of their own. The first exception
+ * thrown by a stage (source, then transform, then sink) stops the others
+ * and is rethrown once all of them finished.
+ *
+ * @param source - batches, produced on the pool
+ * @param transform - called as transform(Batch&)
+ * @param sink - called as sink(Batch&)
+ * @param options - threads and channel capacity
+ * @return PipelineStats - items are counted with batch.size(): read and transform
+ *         count the batches they receive, write the transformed batches
+ */
+template <typename Batch, typename Transform, typename Sink>
+PipelineStats runPipeline(Generator<Batch>& source, Transform transform, Sink sink, const PipelineOptions& options = PipelineOptions())
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    PipelineStats stats;
+    stats.stages.resize(3);
+    stats.stages[0].name = "read";
+    stats.stages[1].name = "transform";
+    stats.stages[2].name = "write";
+
+    // the channels outlive the tasks, the pool outlives both
+    ThreadPool pool(options.threads);
+    Channel<Batch> toTransform(options.channelCapacity, pool);
+    Channel<Batch> toSink(options.channelCapacity, pool);
+
+    std::exception_ptr error;
+    {
+        Task tasks[] = {
+            pipelineSourceStage(source, toTransform, stats.stages[0]),
+            pipelineTransformStage(toTransform, toSink, transform, stats.stages[1]),
+            pipelineSinkStage(toSink, sink, stats.stages[2]),
+        };
+        for (Task& task : tasks)
+        {
+            task.start(pool);
+        }
+        for (Task& task : tasks)
+        {
+            try
+            {
+                task.wait();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    stats.stages[0].waits = toTransform.sendWaits();
+    stats.stages[1].waits = toTransform.receiveWaits() + toSink.sendWaits();
+    stats.stages[2].waits = toSink.receiveWaits();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+#endif // SARCOS_PIPELINE_H
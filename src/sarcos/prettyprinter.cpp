@@ -1,32 +1,73 @@
 /// @file src/sarcos/prettyprinter.cpp
 
 #include "sarcos/prettyprinter.hpp"
+#include "sarcos/treebuilder.hpp"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
+namespace
+{
+    /// decimal places printed for a negative precision, as iostream does
+    const int kDefaultPrecision = 6;
+
+    /// smallest magnitude with more integer digits than the widest value, bounds the work per value
+    const double kMaxFixedMagnitude = 1e63;
+
+    /// next format stamp, shared by all printers so that stamps are unique
+    atomic<unsigned long> nextFormatStamp(1);
+
+    /**
+     * @brief a format stamp never handed out before
+     * 
+     */
+    unsigned long newFormatStamp()
+    {
+        return nextFormatStamp++;
+    }
+}
+
 PrettyPrinter::PrettyPrinter() 
 : m_widthBuffer(2) // default value for spaces between numbers
 , m_precision(3)   // default value for decimal places
+, m_formatStamp(newFormatStamp())
+, m_out(&cout)     // default to standard output
 {}
 
 PrettyPrinter::PrettyPrinter(int widthBuffer, int precision) 
 : m_widthBuffer(widthBuffer) // init desired spaces between numbers
 , m_precision(precision)   // init desired value for decimal places
+, m_formatStamp(newFormatStamp())
+, m_out(&cout)             // default to standard output
 {}
 
 PrettyPrinter::~PrettyPrinter() {}
 
 void PrettyPrinter::print(const Vec3& vec, const Vec3& width)
 {
-    cout << "[ "
-        << setprecision(m_precision) << std::fixed << std::right
-        << setw(width.x) << vec.x 
-        << setw(width.y) << vec.y 
-        << setw(width.z) << vec.z
-        << " ]" << endl;
+    *m_out << "[ ";
+    printValue(vec.x, width.x);
+    printValue(vec.y, width.y);
+    printValue(vec.z, width.z);
+    *m_out << " ]\n";
+}
+
+void PrettyPrinter::print(const MatLineView& line, const Vec3& width)
+{
+    *m_out << "[ ";
+    printValue(line[0], width.x);
+    printValue(line[1], width.y);
+    printValue(line[2], width.z);
+    *m_out << " ]\n";
 }
 
 void PrettyPrinter::print(const Vec3& vec)
@@ -41,15 +82,86 @@ void PrettyPrinter::print(const Vec3& vec)
     print(vec, width);
 
     // extra end line because only printing this vector
-    cout << endl;
+    *m_out << '\n';
+}
+
+int PrettyPrinter::formatValue(double val, char* buf) const
+{
+    const int maxWidth = max(1, min(m_policy.maxWidth, kFormatBufferSize - 1));
+
+    // fixed tokens, whatever the precision, right aligned to the width of the longest
+    const string* token = nullptr;
+    if (std::isnan(val))
+    {
+        token = &m_policy.nanToken;
+    }
+    else if (std::isinf(val))
+    {
+        token = val > 0 ? &m_policy.posInfToken : &m_policy.negInfToken;
+    }
+    if (token)
+    {
+        size_t width = max(m_policy.nanToken.size(), max(m_policy.posInfToken.size(), m_policy.negInfToken.size()));
+        width = min(width, size_t(maxWidth));
+        size_t len = min(token->size(), width);
+        memset(buf, ' ', width - len);
+        token->copy(buf + width - len, len);
+        buf[width] = '\0';
+        return width;
+    }
+
+    // more decimal places than the max width never fit
+    int precision = m_precision < 0 ? kDefaultPrecision : min(m_precision, maxWidth);
+
+    // fixed point notation, unless the value is too large or the string too wide
+    if (fabs(val) < min(m_policy.sciThreshold, kMaxFixedMagnitude))
+    {
+        int len = snprintf(buf, kFormatBufferSize, "%.*f", precision, val);
+        if (len <= maxWidth)
+        {
+            return len;
+        }
+    }
+
+    // scientific notation, dropping decimal places that do not fit the max width.
+    // rounding may carry into a wider exponent (9.96e+99 -> 1.0e+100), so
+    // shorten until it fits: at most maxWidth steps
+    int len = snprintf(buf, kFormatBufferSize, "%.*e", precision, val);
+    while (len > maxWidth && precision > 0)
+    {
+        precision = max(0, precision - (len - maxWidth));
+        len = snprintf(buf, kFormatBufferSize, "%.*e", precision, val);
+    }
+
+    // not even the exponent fits
+    if (len > maxWidth)
+    {
+        memset(buf, m_policy.overflowFill, maxWidth);
+        buf[maxWidth] = '\0';
+        len = maxWidth;
+    }
+    return len;
+}
+
+void PrettyPrinter::printValue(double val, int width) const
+{
+    char buf[kFormatBufferSize];
+    formatValue(val, buf);
+    *m_out << std::right << setw(width) << buf;
+}
+
+string PrettyPrinter::format(double val)
+{
+    char buf[kFormatBufferSize];
+    int len = formatValue(val, buf);
+    return string(buf, len);
 }
 
 int PrettyPrinter::computeStrSize(double val)
 {
-    stringstream ss;
-    // using the same precision as in formatted print, compute the size of the string
-    ss << setprecision(m_precision) << fixed << val;
-    return ss.str().size();
+    // using the same formatting as in the print, compute the size of the string
+    char buf[kFormatBufferSize];
+    return formatValue(val, buf);
 }
 
 int PrettyPrinter::computeMaxSize(const Vec3& vec)
@@ -59,58 +171,176 @@ int PrettyPrinter::computeMaxSize(const Vec3& vec)
     return max(maxWidth, computeStrSize(vec.z));
 }
 
+int PrettyPrinter::computeMaxSize(const MatLineView& line)
+{
+    // return largest of the three elements
+    int maxWidth = max(computeStrSize(line[0]), computeStrSize(line[1]));
+    return max(maxWidth, computeStrSize(line[2]));
+}
+
 void PrettyPrinter::print(const Mat33& mat)
+{
+    print(MatView(mat));
+}
+
+void PrettyPrinter::print(const MatView& view)
 {
     // calculate the max widths for each column for alignment
     Vec3 width;
-    width.x = computeMaxSize(mat.col[0]);
-    width.y = computeMaxSize(mat.col[1]) + m_widthBuffer;
-    width.z = computeMaxSize(mat.col[2]) + m_widthBuffer;
-
-    // make a copy so we can transpose it
-    Mat33 matCopy = copyMat(mat);
+    width.x = computeMaxSize(view.col(0));
+    width.y = computeMaxSize(view.col(1)) + m_widthBuffer;
+    width.z = computeMaxSize(view.col(2)) + m_widthBuffer;
 
-    // transpose mat first for print convenience
-    // and allow re-use of print vector construct
-    transposeMat(matCopy);
-
-    // perform the pretty print
-    print(matCopy.col[0], width);
-    print(matCopy.col[1], width);
-    print(matCopy.col[2], width);
+    // print the rows straight out of the matrix through row views,
+    // so the matrix is neither copied nor transposed
+    print(view.row(0), width);
+    print(view.row(1), width);
+    print(view.row(2), width);
 
     // extra end line to distinguish the matrix output
-    cout << endl;
-
-    // no need to transpose back the copy
+    *m_out << '\n';
 }
 
-void PrettyPrinter::print(Node* node)
+void PrettyPrinter::print(const Node* node)
 {
     // first, print the data from this node
-    cout << "Node data:" << endl;
+    *m_out << "Node data:\n";
     print(node->data);
 
     // print children, if any
     if (node->children)
     {
-        // print an arrow to the children
-        string children = "Children";
-        cout << setw(children.size()/2) << "|" << endl;
-        cout << "Children" << endl;
-        cout << setw(children.size()/2) << "|" << endl;
-        cout << setw(children.size()/2) << "V" << endl << endl;
-
+        printChildrenArrow();
         print(node->children);
     }
 }
 
+void PrettyPrinter::print(const Node* root, size_t count)
+{
+    checkTree(root, count);
+    printTree(root, count, [&](size_t index) { print(root[index].data); });
+}
+
+void PrettyPrinter::print(const CachedMat33& mat)
+{
+    *m_out << refreshLayout(mat.m_mat, mat.m_version, mat.m_layout);
+}
+
+void PrettyPrinter::print(const CachedTree& tree)
+{
+    // validated on construction: every node, as print(const Node*, size_t)
+    printTree(tree.m_root, tree.m_versions.size(), [&](size_t index)
+    {
+        *m_out << refreshLayout(tree.m_root[index].data, tree.m_versions[index], tree.m_layouts[index]);
+    });
+}
+
+const string& PrettyPrinter::refreshLayout(const Mat33& mat, unsigned long version, MatLayout& layout) const
+{
+    if (layout.version == version && layout.formatStamp == m_formatStamp)
+    {
+        return layout.text;
+    }
+
+    // format each value once, then measure the columns on the strings
+    char buf[kFormatBufferSize];
+    const double* values = &mat.col[0].x;
+    for (int c=0; c<3; c++)
+    {
+        size_t widest = 0;
+        for (int r=0; r<3; r++)
+        {
+            int len = formatValue(values[3*c + r], buf);
+            layout.cells[3*c + r].assign(buf, len);
+            widest = max(widest, size_t(len));
+        }
+        layout.widths[c] = int(widest) + (c > 0 ? m_widthBuffer : 0);
+    }
+
+    // same text as print(const MatView&)
+    ostringstream text;
+    for (int r=0; r<3; r++)
+    {
+        text << "[ ";
+        for (int c=0; c<3; c++)
+        {
+            text << std::right << setw(layout.widths[c]) << layout.cells[3*c + r];
+        }
+        text << " ]\n";
+    }
+    text << '\n';
+
+    layout.text = text.str();
+    layout.version = version;
+    layout.formatStamp = m_formatStamp;
+    return layout.text;
+}
+
+void PrettyPrinter::printTree(const Node* root, size_t count, const function<void(size_t)>& printData)
+{
+    // preorder parent of each node: a stack of the open subtrees, with the last index of each
+    vector<pair<size_t, size_t>> open;
+    for (size_t i=0; i<count; i++)
+    {
+        while (!open.empty() && i > open.back().second)
+        {
+            open.pop_back();
+        }
+
+        *m_out << "Node " << i << " data";
+        if (!open.empty())
+        {
+            *m_out << " (child of node " << open.back().first << ")";
+        }
+        *m_out << ":\n";
+        printData(i);
+
+        if (root[i].numChildren)
+        {
+            printChildrenArrow();
+        }
+        open.push_back(make_pair(i, i + root[i].numChildren));
+    }
+}
+
+void PrettyPrinter::printChildrenArrow()
+{
+    string children = "Children";
+    *m_out << setw(children.size()/2) << "|" << '\n';
+    *m_out << "Children\n";
+    *m_out << setw(children.size()/2) << "|" << '\n';
+    *m_out << setw(children.size()/2) << "V" << "\n\n";
+}
+
 void PrettyPrinter::setPrecision(int precision)
 {
     m_precision = precision;
+    m_formatStamp = newFormatStamp();
 }
 
 void PrettyPrinter::setWidthBuffer(int widthBuffer)
 {
     m_widthBuffer = widthBuffer;
+    m_formatStamp = newFormatStamp();
+}
+
+void PrettyPrinter::setFormatPolicy(const FormatPolicy& policy)
+{
+    m_policy = policy;
+    m_formatStamp = newFormatStamp();
+}
+
+unsigned long PrettyPrinter::getFormatStamp() const
+{
+    return m_formatStamp;
+}
+
+const FormatPolicy& PrettyPrinter::getFormatPolicy() const
+{
+    return m_policy;
+}
+
+void PrettyPrinter::setOutputStream(std::ostream& out)
+{
+    m_out = &out;
 }
\ No newline at end of file
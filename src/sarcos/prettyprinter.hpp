@@ -3,8 +3,54 @@
 #ifndef SARCOS_PRETTYPRINTER_H
 #define SARCOS_PRETTYPRINTER_H
 
+#include <cstddef>
+#include <functional>
+#include <ostream>
 #include <string>
+#include "sarcos/cachedmat.hpp"
 #include "sarcos/math.hpp"
+#include "sarcos/matview.hpp"
+
+/**
+ * @brief Rules for formatting a single floating point value
+ * 
+ * Values are printed in fixed point notation, as iostream's std::fixed with
+ * the printer precision (6 decimal places for a negative precision), unless
+ * 
+ * - the value is NaN or infinite: the matching token is printed,
+ *   independent of precision and of the sign of a NaN. All three tokens
+ *   are right aligned to the width of the longest, cut to maxWidth
+ * 
+ * - the magnitude is at or above sciThreshold, or the fixed point
+ *   string would be wider than maxWidth: scientific notation is used,
+ *   dropping decimal places as needed to fit within maxWidth
+ * 
+ * - not even scientific notation without decimal places fits: maxWidth
+ *   overflowFill characters are printed
+ * 
+ * No formatted value is wider than maxWidth, and formatting a value takes
+ * bounded time, whatever the value.
+ */
+struct FormatPolicy
+{
+    /// magnitude at and above which scientific notation is used
+    double sciThreshold = 1e15;
+
+    /// maximum number of characters of a formatted value, 1 to 63
+    int maxWidth = 24;
+
+    /// printed for NaN
+    std::string nanToken = "nan";
+
+    /// printed for positive infinity
+    std::string posInfToken = "inf";
+
+    /// printed for negative infinity
+    std::string negInfToken = "-inf";
+
+    /// fills a value that does not fit within maxWidth
+    char overflowFill = '#';
+};
 
 /**
  * @brief Class for handling all formatted prints of vectors, matrices, nodes, etc.
@@ -41,6 +87,16 @@ public:
      */
     void print(const Vec3& vec, const Vec3& width);
 
+    /**
+     * @brief construct pretty print of a matrix row (or column) view, given width offsets
+     * 
+     * Reads the elements in place, nothing is copied.
+     * 
+     * @param line - row or column of a matrix
+     * @param width - specify width offsets of each element (used to format column placement)
+     */
+    void print(const MatLineView& line, const Vec3& width);
+
     /**
      * @brief pretty print a Vec3
      * 
@@ -72,12 +128,73 @@ public:
      */
     void print(const Mat33& mat);
 
+    /**
+     * @brief pretty print a matrix view
+     * 
+     * Same format as print(const Mat33&), reading the elements in place.
+     * Printing view.transposed() prints the transpose of a (const) matrix
+     * without copying or modifying it.
+     * 
+     * @param view - matrix view
+     */
+    void print(const MatView& view);
+
+    /**
+     * @brief pretty print a matrix with a cached layout
+     * 
+     * Same format as print(const Mat33&). The values are formatted and
+     * measured only if the matrix or the printer settings changed since
+     * the layout was computed, otherwise the cached text is written.
+     * 
+     * @param mat - matrix with its layout
+     */
+    void print(const CachedMat33& mat);
+
     /**
      * @brief print node and descendants
      * 
+     * Follows the children pointers, as linked in main.cpp. Of a tree built
+     * by buildTreeFromParents() or buildTreeFromChildCounts() only the path
+     * of first children is reached, print those with print(const Node*, size_t).
+     * 
      * @param node 
      */
-    void print(Node* node);
+    void print(const Node* node);
+
+    /**
+     * @brief print every node of a tree built in one allocation
+     * 
+     * Nodes are printed in preorder, each under a header with its preorder
+     * index and the index of its parent, followed by the children arrow if
+     * it has children:
+     * 
+     * Node 2 data (child of node 0):
+     * 
+     * Throws std::invalid_argument if validateTree() rejects the tree.
+     * 
+     * @param root - root of a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+     * @param count - number of nodes
+     */
+    void print(const Node* root, size_t count);
+
+    /**
+     * @brief print every node of a tree, with cached layouts
+     * 
+     * Same format as print(const Node*, size_t), the data of each node is
+     * formatted only if it or the printer settings changed since its
+     * layout was computed.
+     * 
+     * @param tree - tree with the layouts of its nodes
+     */
+    void print(const CachedTree& tree);
+
+    /**
+     * @brief format a double value following the precision and format policy
+     * 
+     * @param val - floating point number
+     * @return std::string 
+     */
+    std::string format(double val);
 
     /**
      * @brief compute the size of the formatted string, given a double value
@@ -96,6 +213,14 @@ public:
      */
     int computeMaxSize(const Vec3& vec);
 
+    /**
+     * @brief compute the max string size among the values of a matrix row or column
+     * 
+     * @param line - row or column of a matrix
+     * @return int 
+     */
+    int computeMaxSize(const MatLineView& line);
+
     /**
      * @brief set the precision value
      * 
@@ -111,8 +236,90 @@ public:
      */
     void setWidthBuffer(int widthBuffer);
 
+    /**
+     * @brief set the format policy
+     * 
+     * @param policy - rules for NaN, infinity, huge values and column width
+     */
+    void setFormatPolicy(const FormatPolicy& policy);
+
+    /**
+     * @brief get the format policy
+     * 
+     * @return const FormatPolicy& 
+     */
+    const FormatPolicy& getFormatPolicy() const;
+
+    /**
+     * @brief get the stamp of the current formatting settings
+     * 
+     * Unique across printers, and renewed by every setter changing the
+     * formatted output (precision, width buffer, format policy). Cached
+     * layouts computed under another stamp are recomputed.
+     * 
+     * @return unsigned long 
+     */
+    unsigned long getFormatStamp() const;
+
+    /**
+     * @brief set the stream all prints are written to (standard output by default)
+     * 
+     * Lines end with '\n', the stream is not flushed after each line.
+     * 
+     * @param out - output stream, must outlive the printer or be replaced
+     */
+    void setOutputStream(std::ostream& out);
+
 private:
 
+    /**
+     * @brief format a double value into a buffer
+     * 
+     * @param val - floating point number
+     * @param buf - output, at least kFormatBufferSize characters
+     * @return int - length of the formatted string
+     */
+    int formatValue(double val, char* buf) const;
+
+    /**
+     * @brief bring a cached layout up to date with the data and the printer settings
+     * 
+     * @param mat - matrix
+     * @param version - version of the matrix
+     * @param layout - cached layout, recomputed if stale
+     * @return const std::string& - text of the print
+     */
+    const std::string& refreshLayout(const Mat33& mat, unsigned long version, MatLayout& layout) const;
+
+    /**
+     * @brief print the arrow from a node to its children
+     * 
+     */
+    void printChildrenArrow();
+
+    /**
+     * @brief print the nodes of a built tree in preorder, see print(const Node*, size_t)
+     * 
+     * @param root - root of the tree, already validated
+     * @param count - number of nodes
+     * @param printData - prints the data of the node at a preorder index
+     */
+    void printTree(const Node* root, size_t count, const std::function<void(size_t)>& printData);
+
+    /**
+     * @brief print a formatted value, right justified
+     * 
+     * @param val - floating point number
+     * @param width - total width of the printed field
+     */
+    void printValue(double val, int width) const;
+
+    /**
+     * @brief size of the buffer used to format a single value
+     * 
+     */
+    static const int kFormatBufferSize = 64;
+
     /**
      * @brief default number of spaces between numbers
      * 
@@ -124,6 +331,24 @@ private:
      * 
      */
     int m_precision;
+
+    /**
+     * @brief rules for NaN, infinity, huge values and column width
+     * 
+     */
+    FormatPolicy m_policy;
+
+    /**
+     * @brief stamp of the current formatting settings
+     * 
+     */
+    unsigned long m_formatStamp;
+
+    /**
+     * @brief stream all prints are written to
+     * 
+     */
+    std::ostream* m_out;
 };
 
 #endif // SARCOSPRETTYPRINTER_H
\ No newline at end of file
@@ -0,0 +1,435 @@
+/// @file src/sarcos/reduce.cpp
+
+#include "sarcos/reduce.hpp"
+#include "sarcos/parallel.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SARCOS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    /// values per block, fixed so that results do not depend on the number of threads
+    const size_t kBlockSize = 4096;
+
+    /// smallest number of blocks worth a thread
+    const size_t kMinBlocksPerThread = 16;
+
+    /// accumulators per block, fixed so that results do not depend on the SIMD width
+    const int kLanes = 4;
+
+    /**
+     * @brief compensated running sum
+     *
+     */
+    struct Partial
+    {
+        double sum;
+        double comp;
+    };
+
+    /**
+     * @brief Neumaier step: add x to the sum s, collecting the rounding error in c
+     *
+     * Once the sum is infinite or NaN, c is left alone: its error term would
+     * be inf - inf, turning an infinite sum into NaN.
+     */
+    inline void neumaierAdd(double& s, double& c, double x)
+    {
+        double t = s + x;
+        if (!std::isfinite(t))
+        {
+            s = t;
+            return;
+        }
+        if (fabs(s) >= fabs(x))
+        {
+            c += (s - t) + x;
+        }
+        else
+        {
+            c += (x - t) + s;
+        }
+        s = t;
+    }
+
+    /**
+     * @brief total of a compensated sum, the sum alone once it is infinite or NaN
+     *
+     */
+    inline double total(const Partial& partial)
+    {
+        return std::isfinite(partial.sum) ? partial.sum + partial.comp : partial.sum;
+    }
+
+    /**
+     * @brief add the tail of a block to the lanes, then merge the lanes in lane order
+     *
+     * @param values - tail values, value j goes to lane j
+     * @param count - number of tail values, less than kLanes
+     * @param sums - lane sums
+     * @param comps - lane compensations
+     * @return Partial
+     */
+    inline Partial finishBlock(const double* values, size_t count, double* sums, double* comps)
+    {
+        for (size_t j=0; j<count; j++)
+        {
+            neumaierAdd(sums[j], comps[j], values[j]);
+        }
+
+        Partial partial = {sums[0], comps[0]};
+        for (int j=1; j<kLanes; j++)
+        {
+            neumaierAdd(partial.sum, partial.comp, sums[j]);
+            partial.comp += comps[j];
+        }
+        return partial;
+    }
+
+    Partial sumBlockScalar(const double* values, size_t count)
+    {
+        double sums[kLanes] = {0, 0, 0, 0};
+        double comps[kLanes] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + kLanes <= count; i += kLanes)
+        {
+            for (int j=0; j<kLanes; j++)
+            {
+                neumaierAdd(sums[j], comps[j], values[i + j]);
+            }
+        }
+        return finishBlock(values + i, count - i, sums, comps);
+    }
+
+#ifdef SARCOS_X86_KERNELS
+
+    /**
+     * @brief Neumaier step on 2 lanes, same operations as neumaierAdd()
+     *
+     */
+    __attribute__((target("sse2")))
+    inline void neumaierAddSSE2(__m128d& s, __m128d& c, __m128d x)
+    {
+        const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+        const __m128d t = _mm_add_pd(s, x);
+        const __m128d sIsBig = _mm_cmpge_pd(_mm_and_pd(s, absMask), _mm_and_pd(x, absMask));
+        const __m128d big = _mm_or_pd(_mm_and_pd(sIsBig, s), _mm_andnot_pd(sIsBig, x));
+        const __m128d small = _mm_or_pd(_mm_and_pd(sIsBig, x), _mm_andnot_pd(sIsBig, s));
+
+        // lanes with an infinite or NaN sum add 0 (c never is -0, so c + 0 == c)
+        const __m128d tIsFinite = _mm_cmplt_pd(_mm_and_pd(t, absMask), _mm_set1_pd(HUGE_VAL));
+        c = _mm_add_pd(c, _mm_and_pd(tIsFinite, _mm_add_pd(_mm_sub_pd(big, t), small)));
+        s = t;
+    }
+
+    __attribute__((target("sse2")))
+    Partial sumBlockSSE2(const double* values, size_t count)
+    {
+        // lanes 0,1 and 2,3
+        __m128d s01 = _mm_setzero_pd(), s23 = _mm_setzero_pd();
+        __m128d c01 = _mm_setzero_pd(), c23 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + kLanes <= count; i += kLanes)
+        {
+            neumaierAddSSE2(s01, c01, _mm_loadu_pd(values + i));
+            neumaierAddSSE2(s23, c23, _mm_loadu_pd(values + i + 2));
+        }
+
+        double sums[kLanes], comps[kLanes];
+        _mm_storeu_pd(sums, s01);
+        _mm_storeu_pd(sums + 2, s23);
+        _mm_storeu_pd(comps, c01);
+        _mm_storeu_pd(comps + 2, c23);
+        return finishBlock(values + i, count - i, sums, comps);
+    }
+
+    __attribute__((target("avx2")))
+    Partial sumBlockAVX2(const double* values, size_t count)
+    {
+        const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+        __m256d s = _mm256_setzero_pd();
+        __m256d c = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + kLanes <= count; i += kLanes)
+        {
+            // Neumaier step on 4 lanes, same operations as neumaierAdd()
+            const __m256d x = _mm256_loadu_pd(values + i);
+            const __m256d t = _mm256_add_pd(s, x);
+            const __m256d sIsBig = _mm256_cmp_pd(_mm256_and_pd(s, absMask), _mm256_and_pd(x, absMask), _CMP_GE_OQ);
+            const __m256d big = _mm256_blendv_pd(x, s, sIsBig);
+            const __m256d small = _mm256_blendv_pd(s, x, sIsBig);
+            const __m256d tIsFinite = _mm256_cmp_pd(_mm256_and_pd(t, absMask), _mm256_set1_pd(HUGE_VAL), _CMP_LT_OQ);
+            c = _mm256_add_pd(c, _mm256_and_pd(tIsFinite, _mm256_add_pd(_mm256_sub_pd(big, t), small)));
+            s = t;
+        }
+
+        double sums[kLanes], comps[kLanes];
+        _mm256_storeu_pd(sums, s);
+        _mm256_storeu_pd(comps, c);
+        return finishBlock(values + i, count - i, sums, comps);
+    }
+
+#endif // SARCOS_X86_KERNELS
+
+    /// block kernel
+    typedef Partial (*SumBlockFunc)(const double* values, size_t count);
+
+    /**
+     * @brief block kernel for the SIMD level allowed by the options
+     *
+     * AVX-512 hosts use the AVX2 kernel: the 4 lanes fill an AVX2 register.
+     */
+    SumBlockFunc sumBlockFunc(const ReduceOptions& options)
+    {
+#ifdef SARCOS_X86_KERNELS
+        SimdLevel level = min(options.maxSimdLevel, activeSimdLevel());
+        if (level >= SimdLevel::AVX2)
+        {
+            return sumBlockAVX2;
+        }
+        if (level == SimdLevel::SSE2)
+        {
+            return sumBlockSSE2;
+        }
+#endif
+        return sumBlockScalar;
+    }
+
+    /**
+     * @brief compensated sum of count values, produced block by block
+     *
+     * @param count - number of values
+     * @param options - threads and SIMD level
+     * @param produce - called as produce(begin, n, buffer), returns the n values
+     *                  starting at begin, either in place or written to buffer
+     * @return double
+     */
+    template <typename Produce>
+    double reduceValues(size_t count, const ReduceOptions& options, Produce produce)
+    {
+        const SumBlockFunc sumBlock = sumBlockFunc(options);
+        const size_t numBlocks = (count + kBlockSize - 1) / kBlockSize;
+        vector<Partial> partials(numBlocks);
+
+        parallelFor(numBlocks, kMinBlocksPerThread, options.threads, [&](size_t first, size_t last)
+        {
+            vector<double> buffer(kBlockSize);
+            for (size_t b=first; b<last; b++)
+            {
+                const size_t begin = b * kBlockSize;
+                const size_t n = min(kBlockSize, count - begin);
+                partials[b] = sumBlock(produce(begin, n, buffer.data()), n);
+            }
+        });
+
+        // combine in block order
+        Partial sum = {0, 0};
+        for (const Partial& partial : partials)
+        {
+            neumaierAdd(sum.sum, sum.comp, partial.sum);
+            sum.comp += partial.comp;
+        }
+        return total(sum);
+    }
+
+    /**
+     * @brief euclidean norm of count values, scaled like hypot
+     *
+     * Beyond magnitudes of 2^+-500 the values are scaled by a power of 2, so
+     * their squares neither overflow nor underflow; the scaling is exact.
+     * Infinite if any value is infinite, otherwise NaN if any is NaN.
+     *
+     * @param count - number of values
+     * @param options - threads and SIMD level
+     * @param valueAt - called as valueAt(i), returns value i
+     * @return double
+     */
+    template <typename ValueAt>
+    double reduceNorm(size_t count, const ReduceOptions& options, ValueAt valueAt)
+    {
+        // largest magnitude, and whether there is a NaN
+        const size_t numBlocks = (count + kBlockSize - 1) / kBlockSize;
+        vector<double> largest(numBlocks, 0.0);
+        vector<char> nan(numBlocks, 0);
+        parallelFor(numBlocks, kMinBlocksPerThread, options.threads, [&](size_t first, size_t last)
+        {
+            for (size_t b=first; b<last; b++)
+            {
+                const size_t end = min(count, (b + 1) * kBlockSize);
+                for (size_t i=b * kBlockSize; i<end; i++)
+                {
+                    const double value = fabs(valueAt(i));
+                    largest[b] = fmax(largest[b], value);
+                    nan[b] |= std::isnan(value);
+                }
+            }
+        });
+        const double maxAbs = numBlocks ? *max_element(largest.begin(), largest.end()) : 0.0;
+        if (std::isinf(maxAbs))
+        {
+            return maxAbs;
+        }
+        if (find(nan.begin(), nan.end(), 1) != nan.end())
+        {
+            return NAN;
+        }
+
+        double scale = 1;
+        if (maxAbs > 0x1p+500)
+        {
+            scale = 0x1p-600;
+        }
+        else if (maxAbs < 0x1p-500)
+        {
+            scale = 0x1p+600;
+        }
+
+        return sqrt(reduceValues(count, options, [&](size_t begin, size_t n, double* buffer)
+        {
+            for (size_t i=0; i<n; i++)
+            {
+                const double value = valueAt(begin + i) * scale;
+                buffer[i] = value * value;
+            }
+            return buffer;
+        })) / scale;
+    }
+
+    /**
+     * @brief compensated element-wise sum of count matrices
+     *
+     * @param count - number of matrices
+     * @param options - threads
+     * @param matAt - called as matAt(i), returns matrix i
+     * @return Mat33
+     */
+    template <typename MatAt>
+    Mat33 reduceMats(size_t count, const ReduceOptions& options, MatAt matAt)
+    {
+        const size_t numBlocks = (count + kBlockSize - 1) / kBlockSize;
+        vector<Partial> partials(9 * numBlocks);
+
+        parallelFor(numBlocks, kMinBlocksPerThread, options.threads, [&](size_t first, size_t last)
+        {
+            for (size_t b=first; b<last; b++)
+            {
+                Partial* elements = &partials[9 * b];
+                fill(elements, elements + 9, Partial{0, 0});
+                const size_t end = min(count, (b + 1) * kBlockSize);
+                for (size_t i=b * kBlockSize; i<end; i++)
+                {
+                    const double* values = &matAt(i).col[0].x;
+                    for (int k=0; k<9; k++)
+                    {
+                        neumaierAdd(elements[k].sum, elements[k].comp, values[k]);
+                    }
+                }
+            }
+        });
+
+        // combine in block order
+        Partial sums[9] = {};
+        for (size_t b=0; b<numBlocks; b++)
+        {
+            for (int k=0; k<9; k++)
+            {
+                neumaierAdd(sums[k].sum, sums[k].comp, partials[9 * b + k].sum);
+                sums[k].comp += partials[9 * b + k].comp;
+            }
+        }
+
+        Mat33 result;
+        double* values = &result.col[0].x;
+        for (int k=0; k<9; k++)
+        {
+            values[k] = total(sums[k]);
+        }
+        return result;
+    }
+
+    /// trace, same order of additions everywhere
+    inline double trace(const Mat33& mat)
+    {
+        return (mat.col[0].x + mat.col[1].y) + mat.col[2].z;
+    }
+}
+
+double sumValues(const double* values, size_t count, const ReduceOptions& options)
+{
+    return reduceValues(count, options, [=](size_t begin, size_t, double*)
+    {
+        return values + begin;
+    });
+}
+
+double normValues(const double* values, size_t count, const ReduceOptions& options)
+{
+    return reduceNorm(count, options, [=](size_t i) { return values[i]; });
+}
+
+double sumDotProducts(const Vec3* vecs1, const Vec3* vecs2, size_t count, const ReduceOptions& options)
+{
+    // the dot product kernels give identical results at every SIMD level
+    return reduceValues(count, options, [=](size_t begin, size_t n, double* buffer)
+    {
+        dotProducts(vecs1 + begin, vecs2 + begin, buffer, n);
+        return buffer;
+    });
+}
+
+double sumTraces(const Mat33* mats, size_t count, const ReduceOptions& options)
+{
+    return reduceValues(count, options, [=](size_t begin, size_t n, double* buffer)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            buffer[i] = trace(mats[begin + i]);
+        }
+        return buffer;
+    });
+}
+
+Mat33 sumMats(const Mat33* mats, size_t count, const ReduceOptions& options)
+{
+    return reduceMats(count, options, [=](size_t i) -> const Mat33& { return mats[i]; });
+}
+
+double normMats(const Mat33* mats, size_t count, const ReduceOptions& options)
+{
+    // the matrices are contiguous doubles (mats may be null when count is 0)
+    return normValues(reinterpret_cast<const double*>(mats), 9 * count, options);
+}
+
+Mat33 sumTree(const Node* root, size_t count, const ReduceOptions& options)
+{
+    checkTree(root, count, options.threads);
+    return reduceMats(count, options, [=](size_t i) -> const Mat33& { return root[i].data; });
+}
+
+double sumTreeTraces(const Node* root, size_t count, const ReduceOptions& options)
+{
+    checkTree(root, count, options.threads);
+    return reduceValues(count, options, [=](size_t begin, size_t n, double* buffer)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            buffer[i] = trace(root[begin + i].data);
+        }
+        return buffer;
+    });
+}
+
+double normTree(const Node* root, size_t count, const ReduceOptions& options)
+{
+    // 9 squares per node, in column major order: same result as normMats()
+    checkTree(root, count, options.threads);
+    return reduceNorm(9 * count, options, [=](size_t i) { return (&root[i / 9].data.col[0].x)[i % 9]; });
+}
@@ -0,0 +1,137 @@
+/// @file src/sarcos/reduce.hpp
+
+#ifndef SARCOS_REDUCE_H
+#define SARCOS_REDUCE_H
+
+#include <cstddef>
+#include "sarcos/cpu.hpp"
+#include "sarcos/math.hpp"
+
+/**
+ * @brief Deterministic, compensated reductions over arrays and Node trees
+ *
+ * Values are summed with Neumaier (improved Kahan) compensation, in blocks of
+ * fixed size. Within a block, value i goes to accumulator i % 4, whatever the
+ * SIMD width; block results are then combined in block order. Neither the
+ * number of threads nor the SIMD level changes the shape of the sum, so
+ * results are bit-identical across both.
+ *
+ * Infinite and NaN values give the result of a naive sum: an infinite or
+ * overflowing sum stays infinite instead of turning NaN through its
+ * compensation.
+ */
+
+/**
+ * @brief settings of a reduction
+ *
+ */
+struct ReduceOptions
+{
+    /// number of threads, 0 for one per hardware thread
+    unsigned int threads = 0;
+
+    /// highest SIMD level to use, lowered to activeSimdLevel() if above it
+    SimdLevel maxSimdLevel = SimdLevel::AVX512;
+};
+
+/**
+ * @brief sum of values
+ *
+ * @param values - values
+ * @param count - number of values
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double sumValues(const double* values, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief euclidean norm of values, sqrt of the compensated sum of squares
+ *
+ * Scaled like hypot, so huge or tiny values neither overflow nor underflow.
+ * Infinite if any value is infinite, otherwise NaN if any value is NaN.
+ *
+ * @param values - values
+ * @param count - number of values
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double normValues(const double* values, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief sum of the dot products of pairs of vectors
+ *
+ * @param vecs1 - first vector of each pair
+ * @param vecs2 - second vector of each pair
+ * @param count - number of pairs
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double sumDotProducts(const Vec3* vecs1, const Vec3* vecs2, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief sum of the traces of matrices
+ *
+ * @param mats - matrices
+ * @param count - number of matrices
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double sumTraces(const Mat33* mats, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief element-wise sum of matrices
+ *
+ * @param mats - matrices
+ * @param count - number of matrices
+ * @param options - threads (each element has its own accumulator, no SIMD lanes)
+ * @return Mat33
+ */
+Mat33 sumMats(const Mat33* mats, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief Frobenius norm over the elements of all matrices, scaled as normValues()
+ *
+ * @param mats - matrices
+ * @param count - number of matrices
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double normMats(const Mat33* mats, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief element-wise sum of the data of a tree
+ *
+ * Throws std::invalid_argument if validateTree() rejects the tree.
+ *
+ * @param root - root of a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+ * @param count - number of nodes
+ * @param options - threads
+ * @return Mat33
+ */
+Mat33 sumTree(const Node* root, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief sum of the traces of the data of a tree
+ *
+ * Throws std::invalid_argument if validateTree() rejects the tree.
+ *
+ * @param root - root of a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+ * @param count - number of nodes
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double sumTreeTraces(const Node* root, size_t count, const ReduceOptions& options = ReduceOptions());
+
+/**
+ * @brief Frobenius norm over the data of a tree, scaled as normValues()
+ *
+ * Throws std::invalid_argument if validateTree() rejects the tree.
+ *
+ * @param root - root of a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+ * @param count - number of nodes
+ * @param options - threads and SIMD level
+ * @return double
+ */
+double normTree(const Node* root, size_t count, const ReduceOptions& options = ReduceOptions());
+
+#endif // SARCOS_REDUCE_H
@@ -0,0 +1,185 @@
+/// @file src/sarcos/treebuilder.cpp
+
+#include "sarcos/treebuilder.hpp"
+#include "sarcos/parallel.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    /// smallest number of nodes worth a thread
+    const size_t kMinNodesPerThread = 1 << 15;
+
+    /**
+     * @brief fill the nodes of a tree, once the layout is known
+     *
+     * @param nodes - output, count nodes in preorder
+     * @param data - matrix of each input node
+     * @param positions - preorder position of each input node (nullptr: same as input order)
+     * @param subtreeSizes - size of the subtree of each input node, including itself
+     * @param count - number of nodes
+     * @param threads - number of threads
+     */
+    void fillNodes(Node* nodes, const Mat33* data, const size_t* positions,
+                   const size_t* subtreeSizes, size_t count, unsigned int threads)
+    {
+        parallelFor(count, kMinNodesPerThread, threads, [=](size_t begin, size_t end)
+        {
+            for (size_t i=begin; i<end; i++)
+            {
+                Node& node = nodes[positions ? positions[i] : i];
+                node.data = data[i];
+                node.numChildren = subtreeSizes[i] - 1;
+                node.children = (subtreeSizes[i] > 1) ? &node + 1 : nullptr;
+            }
+        });
+    }
+
+    /**
+     * @brief check the inputs shared by both builders
+     *
+     * @param data - matrix of each node
+     * @param structure - parent indices or children counts
+     * @param count - number of nodes
+     */
+    void checkInput(const Mat33* data, const void* structure, size_t count)
+    {
+        if (count == 0)
+        {
+            throw invalid_argument("a tree needs at least one node");
+        }
+        if (!data || !structure)
+        {
+            throw invalid_argument("tree input arrays must not be null");
+        }
+        if (count - 1 > 0xFFFFFFFFu)
+        {
+            throw invalid_argument("too many nodes for Node::numChildren");
+        }
+    }
+}
+
+Node* buildTreeFromParents(const Mat33* data, const int* parents, size_t count, unsigned int threads)
+{
+    checkInput(data, parents, count);
+    if (parents[0] != -1)
+    {
+        throw invalid_argument("node 0 must be the root (parent -1)");
+    }
+    for (size_t i=1; i<count; i++)
+    {
+        if (parents[i] < 0 || size_t(parents[i]) >= i)
+        {
+            throw invalid_argument("node " + to_string(i) + " must have a parent with a lower index");
+        }
+    }
+
+    // subtree sizes: parents come first, so sweep backwards adding each node to its parent
+    vector<size_t> subtreeSizes(count, 1);
+    for (size_t i=count-1; i>0; i--)
+    {
+        subtreeSizes[parents[i]] += subtreeSizes[i];
+    }
+
+    // preorder positions: each node takes the next free slot of its parent's subtree
+    vector<size_t> positions(count);
+    vector<size_t> nextFree(count);
+    positions[0] = 0;
+    nextFree[0] = 1;
+    for (size_t i=1; i<count; i++)
+    {
+        size_t parent = parents[i];
+        positions[i] = nextFree[parent];
+        nextFree[parent] += subtreeSizes[i];
+        nextFree[i] = positions[i] + 1;
+    }
+
+    Node* nodes = new Node[count];
+    fillNodes(nodes, data, positions.data(), subtreeSizes.data(), count, threads);
+    return nodes;
+}
+
+Node* buildTreeFromChildCounts(const Mat33* data, const unsigned int* childCounts, size_t count, unsigned int threads)
+{
+    checkInput(data, childCounts, count);
+
+    // subtree sizes: sweep backwards, each node gathers the subtrees of its children,
+    // which are the most recently completed ones
+    vector<size_t> subtreeSizes(count);
+    vector<size_t> pending;
+    for (size_t i=count; i-- > 0;)
+    {
+        if (childCounts[i] > pending.size())
+        {
+            throw invalid_argument("node " + to_string(i) + " has more children than nodes follow it");
+        }
+        size_t size = 1;
+        for (unsigned int c=0; c<childCounts[i]; c++)
+        {
+            size += pending.back();
+            pending.pop_back();
+        }
+        subtreeSizes[i] = size;
+        pending.push_back(size);
+    }
+    if (pending.size() != 1)
+    {
+        throw invalid_argument("children counts describe " + to_string(pending.size()) + " trees, expected 1");
+    }
+
+    Node* nodes = new Node[count];
+    fillNodes(nodes, data, nullptr, subtreeSizes.data(), count, threads);
+    return nodes;
+}
+
+bool validateTree(const Node* root, size_t count, unsigned int threads)
+{
+    if (!root || count == 0 || root->numChildren != count - 1)
+    {
+        return false;
+    }
+
+    atomic<bool> valid(true);
+    parallelFor(count, kMinNodesPerThread, threads, [&](size_t begin, size_t end)
+    {
+        for (size_t i=begin; i<end && valid.load(memory_order_relaxed); i++)
+        {
+            const Node* node = root + i;
+            const size_t last = i + node->numChildren;
+            if (last >= count || node->children != (node->numChildren ? node + 1 : nullptr))
+            {
+                valid = false;
+                break;
+            }
+
+            // the subtrees of the direct children must exactly fill the subtree
+            size_t child = i + 1;
+            while (child <= last)
+            {
+                child += 1 + root[child].numChildren;
+            }
+            if (child != last + 1)
+            {
+                valid = false;
+            }
+        }
+    });
+    return valid;
+}
+
+void checkTree(const Node* root, size_t count, unsigned int threads)
+{
+    if (!validateTree(root, count, threads))
+    {
+        throw invalid_argument("not a tree of " + to_string(count) + " nodes built in one allocation");
+    }
+}
+
+void destroyTree(Node* root)
+{
+    delete[] root;
+}
@@ -0,0 +1,91 @@
+/// @file src/sarcos/treebuilder.hpp
+
+#ifndef SARCOS_TREEBUILDER_H
+#define SARCOS_TREEBUILDER_H
+
+#include <cstddef>
+#include "sarcos/math.hpp"
+
+/**
+ * @brief Bulk construction of Node trees from flat arrays
+ * 
+ * A built tree lives in a single allocation, its nodes in preorder:
+ * 
+ * - children points to the first child, which is the next node (nullptr for a leaf)
+ * 
+ * - numChildren is the number of nodes down the tree (all descendants),
+ *   as for the chain of nodes in main.cpp
+ * 
+ * so the subtree of a node spans node[0] .. node[numChildren], and the
+ * direct children of a node are found by skipping over sibling subtrees:
+ * 
+ * for (Node* child = node->children; child <= node + node->numChildren; child += 1 + child->numChildren)
+ * 
+ * Large inputs are built and validated on multiple threads.
+ * Inconsistent inputs throw std::invalid_argument.
+ */
+
+/**
+ * @brief build a tree from an array of parent indices
+ * 
+ * Node i of the input becomes a child of node parents[i].
+ * Node 0 is the root (parents[0] == -1), every other node must have a
+ * parent with a lower index. Siblings keep their relative input order.
+ * 
+ * @param data - matrix of each node
+ * @param parents - parent index of each node, -1 for the root
+ * @param count - number of nodes, at least 1
+ * @param threads - number of threads, 0 for one per hardware thread
+ * @return Node* - root of the tree, release with destroyTree()
+ */
+Node* buildTreeFromParents(const Mat33* data, const int* parents, size_t count, unsigned int threads = 0);
+
+/**
+ * @brief build a tree from preorder arrays of direct children counts
+ * 
+ * The input lists the nodes in preorder (a node, then the subtree of each
+ * of its children in turn), with the number of direct children of each node.
+ * 
+ * @param data - matrix of each node, in preorder
+ * @param childCounts - number of direct children of each node, in preorder
+ * @param count - number of nodes, at least 1
+ * @param threads - number of threads, 0 for one per hardware thread
+ * @return Node* - root of the tree, release with destroyTree()
+ */
+Node* buildTreeFromChildCounts(const Mat33* data, const unsigned int* childCounts, size_t count, unsigned int threads = 0);
+
+/**
+ * @brief check the children pointers and numChildren of a tree built in one allocation
+ * 
+ * Verifies for every node that its subtree stays within the tree, that
+ * children is nullptr exactly for leaves and points to the next node otherwise,
+ * and that numChildren equals the sum of the subtree sizes of its direct children.
+ * 
+ * @param root - root of the tree, followed by the rest of the nodes in preorder
+ * @param count - number of nodes in the allocation
+ * @param threads - number of threads, 0 for one per hardware thread
+ * @return true if the tree is consistent
+ */
+bool validateTree(const Node* root, size_t count, unsigned int threads = 0);
+
+/**
+ * @brief throw std::invalid_argument unless validateTree() accepts the tree
+ * 
+ * Checked by everything indexing the nodes of a built tree by preorder
+ * position: a hand-linked tree (such as the chain in main.cpp) is not
+ * one allocation, and indexing it reads past its nodes.
+ * 
+ * @param root - root of the tree, followed by the rest of the nodes in preorder
+ * @param count - number of nodes in the allocation
+ * @param threads - number of threads, 0 for one per hardware thread
+ */
+void checkTree(const Node* root, size_t count, unsigned int threads = 0);
+
+/**
+ * @brief release a tree built by buildTreeFromParents() or buildTreeFromChildCounts()
+ * 
+ * @param root - root of the tree
+ */
+void destroyTree(Node* root);
+
+#endif // SARCOS_TREEBUILDER_H
@@ -0,0 +1,287 @@
+/// @file src/sarcos/augmentedtree_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/augmentedtree.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief All tests for AugmentedTree
+ * 
+ */
+class AugmentedTreeTest : public testing::Test
+{
+protected:
+
+    /**
+     * @brief random matrix of small integers, so sums are exact
+     * 
+     * @return Mat33 
+     */
+    Mat33 randomMat()
+    {
+        uniform_int_distribution<int> value(-100, 100);
+        Mat33 mat;
+        for (Vec3& col : mat.col)
+        {
+            col = {double(value(rng_)), double(value(rng_)), double(value(rng_))};
+        }
+        return mat;
+    }
+
+    /**
+     * @brief compare the cached aggregates of every node with a full walk
+     * 
+     * @param tree - tree under test
+     */
+    void expectStatsMatchWalk(const AugmentedTree& tree)
+    {
+        for (AugmentedTree::NodeId id=0; id<tree.size(); id++)
+        {
+            SubtreeStats expected = walk(tree, id);
+            const SubtreeStats& actual = tree.stats(id);
+            EXPECT_EQ(expected.size, actual.size) << "node " << id;
+            EXPECT_EQ(expected.height, actual.height) << "node " << id;
+            const double* e[3] = {&expected.min.col[0].x, &expected.max.col[0].x, &expected.sum.col[0].x};
+            const double* a[3] = {&actual.min.col[0].x, &actual.max.col[0].x, &actual.sum.col[0].x};
+            for (int s=0; s<3; s++)
+            {
+                for (int k=0; k<9; k++)
+                {
+                    EXPECT_EQ(e[s][k], a[s][k]) << "node " << id << ", aggregate " << s << ", element " << k;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief aggregates of a subtree by a full walk
+     * 
+     */
+    SubtreeStats walk(const AugmentedTree& tree, AugmentedTree::NodeId id)
+    {
+        SubtreeStats stats = {1, 1, tree.data(id), tree.data(id), tree.data(id)};
+        for (AugmentedTree::NodeId child : tree.children(id))
+        {
+            SubtreeStats childStats = walk(tree, child);
+            stats.size += childStats.size;
+            stats.height = max(stats.height, childStats.height + 1);
+            for (int k=0; k<9; k++)
+            {
+                (&stats.min.col[0].x)[k] = min((&stats.min.col[0].x)[k], (&childStats.min.col[0].x)[k]);
+                (&stats.max.col[0].x)[k] = max((&stats.max.col[0].x)[k], (&childStats.max.col[0].x)[k]);
+                (&stats.sum.col[0].x)[k] += (&childStats.sum.col[0].x)[k];
+            }
+        }
+        return stats;
+    }
+
+    /// fixed seed, reproducible trees
+    mt19937 rng_{7};
+};
+
+/**
+ * @brief A chain like the one in main.cpp
+ * 
+ */
+TEST_F(AugmentedTreeTest, chain)
+{
+    AugmentedTree tree;
+    EXPECT_EQ(0u, tree.height());
+
+    AugmentedTree::NodeId node1 = tree.insert(AugmentedTree::kNoNode, {{{1,-2,13}, {4,-5.4,6}, {7.23,800,-9}}});
+    AugmentedTree::NodeId node2 = tree.insert(node1, {{{2,0,0}, {67,7,6}, {7,-1,9}}});
+    AugmentedTree::NodeId node3 = tree.insert(node2, {{{3,2,5}, {3,5,1}, {7,0,9}}});
+    AugmentedTree::NodeId node4 = tree.insert(node3, {{{4,12,3}, {4,4,7}, {-54.8,8,0}}});
+
+    // numChildren of main.cpp: 3, 2, 1, 0
+    EXPECT_EQ(4u, tree.stats(node1).size);
+    EXPECT_EQ(1u, tree.stats(node4).size);
+    EXPECT_EQ(4u, tree.height());
+    EXPECT_EQ(3u, tree.depth(node4));
+    EXPECT_EQ(node3, tree.parent(node4));
+
+    EXPECT_EQ(800.0, tree.stats(node1).max.col[2].y);
+    EXPECT_EQ(12.0, tree.stats(node2).max.col[0].y);
+    EXPECT_EQ(-54.8, tree.stats(node1).min.col[2].x);
+    EXPECT_EQ(10.0, tree.stats(node1).sum.col[0].x);
+
+    // the max moves away from the root
+    tree.setData(node1, {{{1,-2,13}, {4,-5.4,6}, {7.23,1,-9}}});
+    EXPECT_EQ(8.0, tree.stats(node1).max.col[2].y);
+    expectStatsMatchWalk(tree);
+}
+
+/**
+ * @brief Replacing infinite, NaN and overflowing values clears them from the aggregates
+ * 
+ */
+TEST_F(AugmentedTreeTest, nonFiniteValues)
+{
+    const double inf = numeric_limits<double>::infinity();
+    AugmentedTree tree;
+    AugmentedTree::NodeId root = tree.insert(AugmentedTree::kNoNode, randomMat());
+    AugmentedTree::NodeId child1 = tree.insert(root, randomMat());
+    AugmentedTree::NodeId child2 = tree.insert(root, randomMat());
+    AugmentedTree::NodeId grandchild = tree.insert(child1, randomMat());
+
+    Mat33 bad = tree.data(grandchild);
+    bad.col[1].y = inf;
+    tree.setData(grandchild, bad);
+    EXPECT_EQ(inf, tree.stats(root).sum.col[1].y);
+    EXPECT_EQ(inf, tree.stats(root).max.col[1].y);
+
+    // inf + -inf
+    bad = tree.data(child2);
+    bad.col[1].y = -inf;
+    tree.setData(child2, bad);
+    EXPECT_TRUE(std::isnan(tree.stats(root).sum.col[1].y));
+
+    tree.setData(grandchild, randomMat());
+    tree.setData(child2, randomMat());
+    EXPECT_TRUE(std::isfinite(tree.stats(root).sum.col[1].y));
+    expectStatsMatchWalk(tree);
+
+    bad = tree.data(child1);
+    bad.col[2].z = numeric_limits<double>::quiet_NaN();
+    tree.setData(child1, bad);
+    EXPECT_TRUE(std::isnan(tree.stats(root).sum.col[2].z));
+    tree.setData(child1, randomMat());
+    expectStatsMatchWalk(tree);
+
+    // a sum overflowing to inf over finite values
+    Mat33 huge = tree.data(child1);
+    huge.col[0].x = numeric_limits<double>::max();
+    tree.setData(child1, huge);
+    tree.setData(child2, huge);
+    EXPECT_EQ(inf, tree.stats(root).sum.col[0].x);
+    tree.setData(child2, randomMat());
+    expectStatsMatchWalk(tree);
+}
+
+/**
+ * @brief Data changes on a wide tree visit the ancestors, not the siblings
+ * 
+ */
+TEST_F(AugmentedTreeTest, wideTree)
+{
+    const int numChildren = 100000;
+    AugmentedTree tree;
+    AugmentedTree::NodeId root = tree.insert(AugmentedTree::kNoNode, randomMat());
+    for (int i=0; i<numChildren; i++)
+    {
+        tree.insert(root, randomMat());
+    }
+
+    // values inside the extrema of the siblings, so no min or max is rescanned either
+    uniform_int_distribution<int> value(-50, 50);
+    auto innerMat = [&]()
+    {
+        Mat33 mat;
+        for (Vec3& col : mat.col)
+        {
+            col = {double(value(rng_)), double(value(rng_)), double(value(rng_))};
+        }
+        return mat;
+    };
+    const AugmentedTree::NodeId leaf = numChildren / 2;
+    tree.setData(leaf, innerMat());
+
+    // a walk over the siblings takes about numChildren * 9 additions per change
+    const int numChanges = 2000;
+    const auto start = chrono::steady_clock::now();
+    for (int i=0; i<numChanges; i++)
+    {
+        tree.setData(leaf, innerMat());
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    EXPECT_LT(seconds, 0.1) << numChanges << " changes of one leaf";
+
+    SubtreeStats expected = walk(tree, root);
+    EXPECT_EQ(0, memcmp(&expected.sum, &tree.stats(root).sum, sizeof(Mat33)));
+    EXPECT_EQ(0, memcmp(&expected.min, &tree.stats(root).min, sizeof(Mat33)));
+    EXPECT_EQ(0, memcmp(&expected.max, &tree.stats(root).max, sizeof(Mat33)));
+}
+
+/**
+ * @brief Inserting into a tree that does not accept the node
+ * 
+ */
+TEST_F(AugmentedTreeTest, invalidInsert)
+{
+    AugmentedTree tree;
+    EXPECT_THROW(tree.insert(0, randomMat()), std::invalid_argument);
+    tree.insert(AugmentedTree::kNoNode, randomMat());
+    EXPECT_THROW(tree.insert(AugmentedTree::kNoNode, randomMat()), std::invalid_argument);
+    EXPECT_THROW(tree.insert(5, randomMat()), std::invalid_argument);
+}
+
+/**
+ * @brief Random insertions and data changes keep every cache exact
+ * 
+ */
+TEST_F(AugmentedTreeTest, randomUpdates)
+{
+    AugmentedTree tree;
+    tree.insert(AugmentedTree::kNoNode, randomMat());
+    for (int i=0; i<300; i++)
+    {
+        uniform_int_distribution<unsigned int> node(0, tree.size() - 1);
+        if (i % 3 == 2)
+        {
+            tree.setData(node(rng_), randomMat());
+        }
+        else
+        {
+            tree.insert(node(rng_), randomMat());
+        }
+    }
+    expectStatsMatchWalk(tree);
+}
+
+/**
+ * @brief Aggregates of a tree built in bulk
+ * 
+ */
+TEST_F(AugmentedTreeTest, fromNodeTree)
+{
+    // 0 -> {1 -> {3, 4}, 2 -> {5}}
+    vector<Mat33> data;
+    for (int i=0; i<6; i++)
+    {
+        data.push_back(randomMat());
+    }
+    vector<int> parents = {-1, 0, 0, 1, 1, 2};
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+
+    EXPECT_THROW(AugmentedTree(root, 5), std::invalid_argument);
+    AugmentedTree tree(root, data.size());
+    ASSERT_EQ(6u, tree.size());
+    EXPECT_EQ(3u, tree.height());
+
+    // node ids follow the preorder 0 1 3 4 2 5
+    for (AugmentedTree::NodeId id=0; id<tree.size(); id++)
+    {
+        EXPECT_EQ(root[id].numChildren + 1, tree.stats(id).size);
+        EXPECT_EQ(root[id].data.col[1].z, tree.data(id).col[1].z);
+    }
+    EXPECT_EQ(vector<AugmentedTree::NodeId>({1, 4}), tree.children(0));
+    EXPECT_EQ(2u, tree.depth(5));
+    expectStatsMatchWalk(tree);
+
+    // keeps up with changes after the bulk build
+    tree.insert(5, randomMat());
+    tree.setData(0, randomMat());
+    EXPECT_EQ(4u, tree.height());
+    expectStatsMatchWalk(tree);
+
+    destroyTree(root);
+}
@@ -0,0 +1,390 @@
+/// @file src/sarcos/batch_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/batch.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief parse arguments given without the program name
+ *
+ */
+static bool parse(vector<const char*> args, BatchOptions& options, string& error)
+{
+    args.insert(args.begin(), "sarcos_quiz");
+    return parseBatchOptions(int(args.size()), args.data(), options, error);
+}
+
+/**
+ * @brief run a batch over text input
+ *
+ */
+static string run(const BatchOptions& options, const string& input, BatchStats* stats = nullptr)
+{
+    istringstream in(input);
+    ostringstream out;
+    BatchStats result = runBatch(options, in, out);
+    if (stats)
+    {
+        *stats = result;
+    }
+    return out.str();
+}
+
+/**
+ * @brief a double with the 17 significant digits of compact output
+ *
+ */
+static string formatted(double value)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.17g", value);
+    return buf;
+}
+
+/**
+ * @brief compact output options
+ *
+ */
+static BatchOptions compactOptions(RecordType type, Operation operation)
+{
+    BatchOptions options;
+    options.type = type;
+    options.operation = operation;
+    options.outputFormat = OutputFormat::Compact;
+    options.precision = 1;
+    return options;
+}
+
+/**
+ * @brief Defaults, and every option parsed
+ *
+ */
+TEST(BatchTest, parseOptions)
+{
+    BatchOptions options;
+    string error;
+    ASSERT_TRUE(parse({}, options, error));
+    EXPECT_EQ("-", options.inputPath);
+    EXPECT_EQ(RecordType::Mat33, options.type);
+    EXPECT_EQ(Operation::Copy, options.operation);
+    EXPECT_FALSE(options.demo);
+
+    ASSERT_TRUE(parse({"-i", "in.bin", "-o", "out.txt", "--type", "vec3", "--op", "dot",
+                       "--input-format", "binary", "--output-format", "compact", "--threads", "4",
+                       "--batch-size", "100", "--io-buffer", "0", "--precision", "6", "--stats"}, options, error)) << error;
+    EXPECT_EQ("in.bin", options.inputPath);
+    EXPECT_EQ("out.txt", options.outputPath);
+    EXPECT_EQ(RecordType::Vec3, options.type);
+    EXPECT_EQ(Operation::Dot, options.operation);
+    EXPECT_EQ(InputFormat::Binary, options.inputFormat);
+    EXPECT_EQ(OutputFormat::Compact, options.outputFormat);
+    EXPECT_EQ(4u, options.threads);
+    EXPECT_EQ(100u, options.batchSize);
+    EXPECT_EQ(0u, options.ioBufferSize);
+    EXPECT_EQ(6, options.precision);
+    EXPECT_TRUE(options.stats);
+}
+
+/**
+ * @brief Unknown options, bad values and unsupported operations are rejected
+ *
+ */
+TEST(BatchTest, parseOptions_Invalid)
+{
+    const vector<vector<const char*>> invalid = {
+        {"--bogus"},
+        {"--type"},
+        {"--type", "mat44"},
+        {"--threads", "-1"},
+        {"--batch-size", "0"},
+        {"--precision", "abc"},
+        {"--type", "vec3", "--op", "transpose"},
+        {"--type", "mat33", "--op", "dot"},
+        {"--type", "node", "--op", "multiply"},
+    };
+    for (const vector<const char*>& args : invalid)
+    {
+        BatchOptions options;
+        string error;
+        EXPECT_FALSE(parse(args, options, error)) << args[0];
+        EXPECT_FALSE(error.empty());
+    }
+}
+
+/**
+ * @brief Transpose mat33 records, skipping comments and blank lines
+ *
+ */
+TEST(BatchTest, transposeMats)
+{
+    BatchStats stats;
+    string out = run(compactOptions(RecordType::Mat33, Operation::Transpose),
+                     "# two matrices\n"
+                     "1 2 3 4 5 6 7 8 9\n"
+                     "\n"
+                     "  -1 0 0 0 -2 0 0 0 -3  \n", &stats);
+    EXPECT_EQ("1 4 7 2 5 8 3 6 9\n"
+              "-1 0 0 0 -2 0 0 0 -3\n", out);
+    EXPECT_EQ(2u, stats.recordsIn);
+    EXPECT_EQ(2u, stats.recordsOut);
+}
+
+/**
+ * @brief Dot products of consecutive pairs of vec3 records
+ *
+ */
+TEST(BatchTest, dotVecs)
+{
+    string out = run(compactOptions(RecordType::Vec3, Operation::Dot),
+                     "1 2 3\n4 5 6\n4.6 -5 10\n3 9 -1\n");
+    EXPECT_EQ("32\n" + formatted(4.6 * 3 - 5 * 9 + 10 * -1.0) + "\n", out);
+}
+
+/**
+ * @brief Products of consecutive pairs of mat33 records
+ *
+ */
+TEST(BatchTest, multiplyMats)
+{
+    // identity * A = A
+    string out = run(compactOptions(RecordType::Mat33, Operation::Multiply),
+                     "1 0 0 0 1 0 0 0 1\n1 2 3 4 5 6 7 8 9\n");
+    EXPECT_EQ("1 2 3 4 5 6 7 8 9\n", out);
+}
+
+/**
+ * @brief Compact output reads back as the same doubles, whatever the precision
+ *
+ */
+TEST(BatchTest, compactRoundTrip)
+{
+    const vector<double> values = {0.1, 1.0 / 3, -2.5e-300, 1e300, 123456789.123456789, -0.0,
+                                   numeric_limits<double>::max(), numeric_limits<double>::denorm_min(), 5e-324 * 3};
+    ostringstream input;
+    for (double value : values)
+    {
+        input << formatted(value) << " " << formatted(-value) << " " << formatted(value / 7) << "\n";
+    }
+
+    BatchOptions options = compactOptions(RecordType::Vec3, Operation::Copy);
+    const string out = run(options, input.str());
+    EXPECT_EQ(input.str(), out);
+
+    // strtod, as the reader, gives back the same doubles bit for bit
+    const char* p = out.c_str();
+    for (double value : values)
+    {
+        for (double expected : {value, -value, value / 7})
+        {
+            char* end = nullptr;
+            const double read = strtod(p, &end);
+            ASSERT_NE(p, end);
+            EXPECT_EQ(0, memcmp(&expected, &read, sizeof(double))) << formatted(expected);
+            p = end;
+        }
+    }
+
+    // infinity and NaN, as printf writes them, which strtod reads
+    EXPECT_EQ("inf -inf nan\n", run(options, "inf -inf nan\n"));
+}
+
+/**
+ * @brief Pretty output goes through PrettyPrinter
+ *
+ */
+TEST(BatchTest, prettyOutput)
+{
+    BatchOptions options;
+    options.type = RecordType::Vec3;
+    options.precision = 1;
+    EXPECT_EQ("[ 1.0  2.0  3.0 ]\n\n", run(options, "1 2 3\n"));
+}
+
+/**
+ * @brief Binary input gives the same records as text input
+ *
+ */
+TEST(BatchTest, binaryInput)
+{
+    vector<double> values = {1, 2, 3, 4, 5, 6};
+    string input(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+
+    BatchOptions options = compactOptions(RecordType::Vec3, Operation::Copy);
+    options.inputFormat = InputFormat::Binary;
+    BatchStats stats;
+    EXPECT_EQ("1 2 3\n4 5 6\n", run(options, input, &stats));
+    EXPECT_EQ(input.size(), stats.bytesIn);
+
+    // truncated record
+    EXPECT_THROW(run(options, input.substr(0, input.size() - 1)), runtime_error);
+}
+
+/**
+ * @brief Node records are built into a tree, pretty printed in preorder, compact in input order
+ *
+ */
+TEST(BatchTest, nodeTree)
+{
+    // 0 -> {1 -> {3}, 2}, listed out of preorder
+    const string input = "-1 0 0 0 0 0 0 0 0 0\n"
+                         "0 1 2 3 4 5 6 7 8 9\n"
+                         "0 2 2 2 2 2 2 2 2 2\n"
+                         "1 3 3 3 3 3 3 3 3 3\n";
+    BatchOptions options = compactOptions(RecordType::Node, Operation::Transpose);
+    BatchStats stats;
+    string out = run(options, input, &stats);
+    EXPECT_EQ("-1 0 0 0 0 0 0 0 0 0\n"
+              "0 1 4 7 2 5 8 3 6 9\n"
+              "0 2 2 2 2 2 2 2 2 2\n"
+              "1 3 3 3 3 3 3 3 3 3\n", out);
+    EXPECT_EQ(4u, stats.recordsOut);
+
+    // a copy reads back as the input
+    options.operation = Operation::Copy;
+    EXPECT_EQ(input, run(options, input));
+
+    // pretty output: preorder index and parent
+    options.outputFormat = OutputFormat::Pretty;
+    out = run(options, input);
+    const size_t node3 = out.find("Node 2 (parent 1, 0 below):\n[ 3.0");
+    const size_t node2 = out.find("Node 3 (parent 0, 0 below):\n[ 2.0");
+    EXPECT_NE(string::npos, node3);
+    EXPECT_NE(string::npos, node2);
+    EXPECT_LT(node3, node2);
+
+    // the parent of the root is not -1
+    EXPECT_THROW(run(options, "0 0 0 0 0 0 0 0 0 0\n"), invalid_argument);
+}
+
+/**
+ * @brief Malformed records report their line
+ *
+ */
+TEST(BatchTest, badInput)
+{
+    BatchOptions options = compactOptions(RecordType::Vec3, Operation::Copy);
+    try
+    {
+        run(options, "1 2 3\n1 2\n");
+        FAIL() << "expected runtime_error";
+    }
+    catch (const runtime_error& e)
+    {
+        EXPECT_NE(string::npos, string(e.what()).find("line 2"));
+    }
+    EXPECT_THROW(run(options, "1 2 3 4\n"), runtime_error);
+    EXPECT_THROW(run(options, "1 2 x\n"), runtime_error);
+
+    // a pair operation with an odd number of records
+    EXPECT_THROW(run(compactOptions(RecordType::Vec3, Operation::Dot), "1 2 3\n"), runtime_error);
+}
+
+/**
+ * @brief Threads and batch sizes do not change the output
+ *
+ */
+TEST(BatchTest, threadsAndBatchSizes)
+{
+    ostringstream input;
+    for (int i=0; i<5000; i++)
+    {
+        for (int k=0; k<9; k++)
+        {
+            input << (i * 9 + k) % 17 - 8 << (k < 8 ? " " : "\n");
+        }
+    }
+
+    BatchOptions options = compactOptions(RecordType::Mat33, Operation::Multiply);
+    const string expected = run(options, input.str());
+    for (unsigned int threads : {2u, 4u})
+    {
+        for (size_t batchSize : {size_t(1), size_t(3), size_t(2048)})
+        {
+            options.threads = threads;
+            options.batchSize = batchSize;
+            EXPECT_EQ(expected, run(options, input.str())) << threads << " threads, batch " << batchSize;
+        }
+    }
+}
+
+/**
+ * @brief The pipeline writes the same output as the sequential run, and reports its stages
+ *
+ */
+TEST(BatchTest, pipeline)
+{
+    string error;
+    BatchOptions parsed;
+    ASSERT_TRUE(parse({"--pipeline"}, parsed, error)) << error;
+    EXPECT_TRUE(parsed.pipeline);
+
+    ostringstream input;
+    for (int i=0; i<3000; i++)
+    {
+        for (int k=0; k<9; k++)
+        {
+            input << (i * 7 + k) % 13 - 6 << (k < 8 ? " " : "\n");
+        }
+    }
+
+    for (Operation operation : {Operation::Copy, Operation::Transpose, Operation::Multiply})
+    {
+        BatchOptions options = compactOptions(RecordType::Mat33, operation);
+        options.batchSize = 100;
+        const string expected = run(options, input.str());
+
+        options.pipeline = true;
+        BatchStats stats;
+        EXPECT_EQ(expected, run(options, input.str(), &stats));
+        EXPECT_EQ(3000u, stats.recordsIn);
+        ASSERT_EQ(3u, stats.stages.size());
+        EXPECT_EQ(30u, stats.stages[0].batches);
+        EXPECT_EQ(3000u, stats.stages[1].items);
+        EXPECT_EQ(30u, stats.stages[2].batches);
+        EXPECT_EQ(stats.recordsOut, stats.stages[2].items);
+    }
+
+    BatchOptions options = compactOptions(RecordType::Vec3, Operation::Dot);
+    options.pipeline = true;
+    EXPECT_EQ("14\n", run(options, "1 2 3\n1 2 3\n"));
+
+    // errors of the read stage reach the caller
+    options.batchSize = 1;
+    EXPECT_THROW(run(options, "1 2 3\n1 2 3\n1 2\n"), runtime_error);
+}
+
+/**
+ * @brief The write stage of the pipeline counts the records written, not the records read
+ *
+ */
+TEST(BatchTest, pipelineStatsMultiply)
+{
+    BatchOptions options = compactOptions(RecordType::Mat33, Operation::Multiply);
+    options.pipeline = true;
+    BatchStats stats;
+    run(options, "1 0 0 0 1 0 0 0 1\n1 2 3 4 5 6 7 8 9\n", &stats);
+    EXPECT_EQ(2u, stats.recordsIn);
+    EXPECT_EQ(1u, stats.recordsOut);
+    ASSERT_EQ(3u, stats.stages.size());
+    EXPECT_EQ(2u, stats.stages[0].items);
+    EXPECT_EQ(2u, stats.stages[1].items);
+    EXPECT_EQ(1u, stats.stages[2].items);
+
+    // vec3 dot: two records in, one dot out
+    options = compactOptions(RecordType::Vec3, Operation::Dot);
+    options.pipeline = true;
+    stats = BatchStats();
+    run(options, "1 2 3\n1 2 3\n", &stats);
+    EXPECT_EQ(2u, stats.stages[0].items);
+    EXPECT_EQ(1u, stats.stages[2].items);
+}
@@ -0,0 +1,157 @@
+/// @file src/sarcos/cachedmat_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/cachedmat.hpp"
+#include "sarcos/prettyprinter.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Prints cached and plain matrices to strings
+ *
+ */
+class CachedMatTest : public testing::Test
+{
+protected:
+
+    CachedMatTest()
+    {
+        printer_.setOutputStream(out_);
+    }
+
+    /// output of a print
+    template <typename T>
+    string printed(const T& value)
+    {
+        out_.str("");
+        printer_.print(value);
+        return out_.str();
+    }
+
+    /// output of the print of a built tree
+    string printed(const Node* root, size_t count)
+    {
+        out_.str("");
+        printer_.print(root, count);
+        return out_.str();
+    }
+
+    const Mat33 mat_ = {{{1,-2,13}, {4,-5.4,6}, {7.23,800,-9}}};
+    PrettyPrinter printer_;
+    ostringstream out_;
+};
+
+/**
+ * @brief Same output as the plain print, with or without a cached layout
+ *
+ */
+TEST_F(CachedMatTest, print)
+{
+    const CachedMat33 cached(mat_);
+    const string expected = printed(mat_);
+    EXPECT_EQ(expected, printed(cached));
+    EXPECT_EQ(expected, printed(cached));
+
+    Mat33 special = {{{NAN,INFINITY,-INFINITY}, {1e300,-0.0,5e-324}, {0.0005,-1e15,2}}};
+    EXPECT_EQ(printed(special), printed(CachedMat33(special)));
+}
+
+/**
+ * @brief The setters invalidate the layout
+ *
+ */
+TEST_F(CachedMatTest, set)
+{
+    CachedMat33 cached(mat_);
+    printed(cached);
+    const unsigned long version = cached.version();
+
+    Mat33 changed = mat_;
+    changed.col[2].y = -123456.5;
+    cached.set(1, 2, -123456.5);
+    EXPECT_GT(cached.version(), version);
+    EXPECT_EQ(-123456.5, cached.get(1, 2));
+    EXPECT_EQ(printed(changed), printed(cached));
+
+    changed = {{{0,0,0}, {0,1,0}, {0,0,0}}};
+    cached.set(changed);
+    EXPECT_EQ(printed(changed), printed(cached));
+
+    EXPECT_THROW(cached.set(3, 0, 1.0), out_of_range);
+    EXPECT_THROW(cached.get(0, -1), out_of_range);
+}
+
+/**
+ * @brief Changing the printer settings, or printing with another printer, recomputes the layout
+ *
+ */
+TEST_F(CachedMatTest, printerSettings)
+{
+    const CachedMat33 cached(mat_);
+    printed(cached);
+
+    const unsigned long stamp = printer_.getFormatStamp();
+    printer_.setPrecision(1);
+    EXPECT_NE(stamp, printer_.getFormatStamp());
+    EXPECT_EQ(printed(mat_), printed(cached));
+
+    printer_.setWidthBuffer(5);
+    EXPECT_EQ(printed(mat_), printed(cached));
+
+    FormatPolicy policy;
+    policy.sciThreshold = 100;
+    printer_.setFormatPolicy(policy);
+    EXPECT_EQ(printed(mat_), printed(cached));
+
+    // a printer with the default settings
+    PrettyPrinter other;
+    ostringstream otherOut;
+    other.setOutputStream(otherOut);
+    EXPECT_NE(printer_.getFormatStamp(), other.getFormatStamp());
+    other.print(mat_);
+    const string expected = otherOut.str();
+    otherOut.str("");
+    other.print(cached);
+    EXPECT_EQ(expected, otherOut.str());
+}
+
+/**
+ * @brief Tree prints match print(const Node*, size_t), siblings included, and node setters invalidate their layout
+ *
+ */
+TEST_F(CachedMatTest, tree)
+{
+    // 0 -> {1 -> {2, 3}, 4}
+    vector<Mat33> data(5, mat_);
+    for (int i=0; i<5; i++)
+    {
+        data[i].col[0].x = i * 1000;
+    }
+    vector<int> parents = {-1, 0, 1, 1, 0};
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+
+    CachedTree tree(root, data.size());
+    EXPECT_EQ(5u, tree.size());
+    const string expected = printed(root, data.size());
+    EXPECT_NE(string::npos, expected.find("Node 3 data (child of node 1):\n"));
+    EXPECT_NE(string::npos, expected.find("Node 4 data (child of node 0):\n[ 4000.000"));
+    EXPECT_EQ(expected, printed(tree));
+    EXPECT_EQ(expected, printed(tree));
+
+    tree.set(3, 0, 0, -7.5);
+    EXPECT_EQ(-7.5, root[3].data.col[0].x);
+    EXPECT_EQ(printed(root, data.size()), printed(tree));
+
+    tree.setData(4, data[0]);
+    EXPECT_EQ(0.0, tree.data(4).col[0].x);
+    EXPECT_EQ(printed(root, data.size()), printed(tree));
+
+    EXPECT_THROW(tree.setData(5, mat_), out_of_range);
+    destroyTree(root);
+}
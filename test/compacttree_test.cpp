@@ -0,0 +1,166 @@
+/// @file src/sarcos/compacttree_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/compacttree.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Builds a branching tree with repeated matrices
+ *
+ *        0
+ *      / | \
+ *     1  2  3
+ *    / \    |
+ *   4   5   6
+ */
+class CompactTreeTest : public testing::Test
+{
+protected:
+
+    void SetUp() override
+    {
+        vector<int> parents = {-1, 0, 0, 0, 1, 1, 3};
+        for (int i=0; i<7; i++)
+        {
+            // nodes 4, 5 and 6 share a matrix
+            const double v = i < 4 ? i - 1.25 : 100.5;
+            data_.push_back({{{v, -2*v, 1e-3}, {3, 4.75, -5}, {6, 7, v*v}}});
+        }
+        root_ = buildTreeFromParents(data_.data(), parents.data(), data_.size());
+    }
+
+    void TearDown() override
+    {
+        destroyTree(root_);
+    }
+
+    /// largest absolute difference between the data of two trees
+    static double maxError(const CompactTree& tree, const Node* root)
+    {
+        double error = 0;
+        for (size_t i=0; i<tree.size(); i++)
+        {
+            const Mat33 mat = tree.data(i);
+            for (int k=0; k<9; k++)
+            {
+                error = max(error, fabs((&mat.col[0].x)[k] - (&root[i].data.col[0].x)[k]));
+            }
+        }
+        return error;
+    }
+
+    vector<Mat33> data_;
+    Node* root_ = nullptr;
+};
+
+/**
+ * @brief Same structure as the source tree, exact doubles
+ *
+ */
+TEST_F(CompactTreeTest, structure)
+{
+    CompactTree tree(root_, data_.size());
+    ASSERT_EQ(7u, tree.size());
+    for (CompactTree::Index i=0; i<7; i++)
+    {
+        EXPECT_EQ(root_[i].numChildren, tree.numChildren(i));
+        EXPECT_EQ(root_[i].children ? CompactTree::Index(root_[i].children - root_) : CompactTree::kNoNode, tree.firstChild(i));
+    }
+    EXPECT_EQ(0.0, maxError(tree, root_));
+    EXPECT_THROW(tree.data(7), out_of_range);
+
+    // back to the same Node tree
+    Node* copy = tree.toTree();
+    EXPECT_TRUE(validateTree(copy, 7));
+    for (int i=0; i<7; i++)
+    {
+        EXPECT_EQ(root_[i].numChildren, copy[i].numChildren);
+        EXPECT_EQ(root_[i].data.col[2].z, copy[i].data.col[2].z);
+    }
+    destroyTree(copy);
+}
+
+/**
+ * @brief Float and quantized storage stay within their error bounds
+ *
+ */
+TEST_F(CompactTreeTest, storage)
+{
+    CompactTreeOptions options;
+    options.storage = MatStorage::Float;
+    CompactTree floats(root_, data_.size(), options);
+    EXPECT_LT(maxError(floats, root_), 1e-5 * 10100);
+
+    options.storage = MatStorage::Quantized16;
+    CompactTree quantized(root_, data_.size(), options);
+    for (size_t i=0; i<7; i++)
+    {
+        double maxAbs = 0;
+        for (int k=0; k<9; k++)
+        {
+            maxAbs = max(maxAbs, fabs((&root_[i].data.col[0].x)[k]));
+        }
+        const Mat33 mat = quantized.data(i);
+        for (int k=0; k<9; k++)
+        {
+            EXPECT_LE(fabs((&mat.col[0].x)[k] - (&root_[i].data.col[0].x)[k]), maxAbs / 65534 * (1 + 1e-12));
+        }
+    }
+
+    // quantization needs finite values
+    root_[3].data.col[1].y = NAN;
+    EXPECT_THROW(CompactTree(root_, data_.size(), options), invalid_argument);
+}
+
+/**
+ * @brief Identical matrices are stored once
+ *
+ */
+TEST_F(CompactTreeTest, deduplicate)
+{
+    CompactTreeOptions options;
+    options.deduplicate = true;
+    for (MatStorage storage : {MatStorage::Double, MatStorage::Float, MatStorage::Quantized16})
+    {
+        options.storage = storage;
+        CompactTree tree(root_, data_.size(), options);
+        EXPECT_EQ(5u, tree.footprint().numMatrices);
+
+        options.deduplicate = false;
+        EXPECT_EQ(maxError(CompactTree(root_, data_.size(), options), root_), maxError(tree, root_));
+        options.deduplicate = true;
+    }
+}
+
+/**
+ * @brief Footprint of each representation
+ *
+ */
+TEST_F(CompactTreeTest, footprint)
+{
+    const MemoryFootprint nodes = footprintOf(root_, data_.size());
+    EXPECT_EQ(7u, nodes.numNodes);
+    EXPECT_EQ(7 * sizeof(Node), nodes.totalBytes());
+    EXPECT_EQ(double(sizeof(Node)), nodes.bytesPerNode());
+
+    CompactTreeOptions options;
+    MemoryFootprint compact = CompactTree(root_, data_.size(), options).footprint();
+    EXPECT_EQ(7 * 4u, compact.structureBytes);
+    EXPECT_EQ(7 * 72u, compact.matrixBytes);
+
+    options.storage = MatStorage::Float;
+    EXPECT_EQ(7 * 36u, CompactTree(root_, data_.size(), options).footprint().matrixBytes);
+
+    options.storage = MatStorage::Quantized16;
+    options.deduplicate = true;
+    compact = CompactTree(root_, data_.size(), options).footprint();
+    EXPECT_EQ(7 * 8u, compact.structureBytes);
+    EXPECT_EQ(5 * 26u, compact.matrixBytes);
+    EXPECT_EQ(7 * 8u + 5 * 26u, compact.totalBytes());
+    EXPECT_LT(compact.bytesPerNode(), nodes.bytesPerNode() / 2);
+}
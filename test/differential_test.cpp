@@ -0,0 +1,241 @@
+/// @file src/sarcos/differential_test.cpp
+
+#include <gtest/gtest.h>
+#include "reference.hpp"
+#include "sarcos/math_kernels.hpp"
+#include <cfloat>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Compares PrettyPrinter and the SIMD kernels with the reference
+ *        implementations over adversarial and random doubles
+ *
+ */
+class DifferentialTest : public testing::Test
+{
+protected:
+
+    DifferentialTest()
+    : rng_(20240611)
+    {}
+
+    /**
+     * @brief values at the edges of the formatting and arithmetic rules
+     *
+     */
+    static vector<double> adversarialValues()
+    {
+        const double inf = numeric_limits<double>::infinity();
+        vector<double> values = {
+            0.0, -0.0, 1.0, -1.0,
+            numeric_limits<double>::quiet_NaN(), -numeric_limits<double>::quiet_NaN(), inf, -inf,
+            DBL_MIN, -DBL_MIN, numeric_limits<double>::denorm_min(), -numeric_limits<double>::denorm_min(),
+            DBL_MAX, -DBL_MAX, DBL_EPSILON, 1.0 + DBL_EPSILON, 1.0 - DBL_EPSILON / 2,
+            // ties and near ties of the decimal rounding
+            0.5, 1.5, 2.5, 0.0005, 0.0015, 0.0025, 1.0005, 0.125, 0.375, 9.9995, 99.9995, -0.0005,
+            // fixed / scientific switch and the width limit
+            1e15, nextafter(1e15, 0.0), -1e15, 1e21, nextafter(1e21, 0.0), 1e22, 123456789012345678.0,
+            1e-5, 1e-300, 4.6, -5.4, 7.23, 800, -54.8,
+            // rounding carries into a wider exponent: 9.96e+99 -> 1.0e+100
+            9.96e99, nextafter(1e100, 0.0), -9.995e99, 9.5e-100,
+        };
+        return values;
+    }
+
+    /**
+     * @brief random bit pattern: any double, NaN payloads and denormals included
+     *
+     */
+    double randomBits()
+    {
+        uint64_t bits = rng_();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief random value near a decimal rounding tie at a random scale
+     *
+     */
+    double randomDecimal()
+    {
+        const int decimals = uniform_int_distribution<int>(0, 8)(rng_);
+        const double scale = pow(10.0, decimals);
+        const double tie = (double(uniform_int_distribution<int64_t>(-1000000, 1000000)(rng_)) + 0.5) / scale;
+        const int ulps = uniform_int_distribution<int>(-2, 2)(rng_);
+        double value = tie;
+        for (int i=0; i<abs(ulps); i++)
+        {
+            value = nextafter(value, ulps > 0 ? DBL_MAX : -DBL_MAX);
+        }
+        return value;
+    }
+
+    /**
+     * @brief adversarial values, then random bit patterns and near ties
+     *
+     */
+    vector<double> testValues(size_t numRandom)
+    {
+        vector<double> values = adversarialValues();
+        for (size_t i=0; i<numRandom; i++)
+        {
+            values.push_back(i % 2 ? randomBits() : randomDecimal());
+        }
+        return values;
+    }
+
+    /**
+     * @brief printer settings covering the precision range and the policy limits
+     *
+     */
+    static vector<ReferenceSettings> settingsCases()
+    {
+        vector<ReferenceSettings> cases;
+        for (int precision : {-1, 0, 1, 3, 6, 17, 30, 40})
+        {
+            ReferenceSettings settings;
+            settings.precision = precision;
+            cases.push_back(settings);
+        }
+
+        // narrower than the exponent of most values, or just as wide as a carried one
+        for (int maxWidth : {1, 3, 5, 6, 7})
+        {
+            ReferenceSettings narrow;
+            narrow.policy.maxWidth = maxWidth;
+            cases.push_back(narrow);
+        }
+
+        ReferenceSettings custom;
+        custom.widthBuffer = 0;
+        custom.policy.sciThreshold = 1e3;
+        custom.policy.maxWidth = 63;
+        custom.policy.nanToken = "NaN";
+        custom.policy.posInfToken = "+Infinity";
+        custom.policy.negInfToken = string(80, '-');
+        cases.push_back(custom);
+        return cases;
+    }
+
+    mt19937_64 rng_;
+};
+
+/**
+ * @brief format() prints like iostream where the value fits, and follows the policy elsewhere
+ *
+ */
+TEST_F(DifferentialTest, format)
+{
+    const vector<double> values = testValues(20000);
+    for (const ReferenceSettings& settings : settingsCases())
+    {
+        ostringstream sink;
+        PrettyPrinter printer;
+        configurePrinter(printer, settings, sink);
+        for (double value : values)
+        {
+            const string formatted = printer.format(value);
+            ASSERT_EQ("", checkFormat(value, formatted, settings))
+                << "value " << hexfloat << value << " formatted as \"" << formatted
+                << "\", precision " << dec << settings.precision << ", max width " << settings.policy.maxWidth;
+        }
+    }
+}
+
+/**
+ * @brief print() of vectors and matrices lays the formatted values out in aligned columns
+ *
+ */
+TEST_F(DifferentialTest, print)
+{
+    const vector<double> values = testValues(9000);
+    for (const ReferenceSettings& settings : settingsCases())
+    {
+        ostringstream out;
+        PrettyPrinter printer;
+        configurePrinter(printer, settings, out);
+        auto format = [&](double value) { return printer.format(value); };
+        for (size_t i=0; i + 9 <= values.size(); i += 9)
+        {
+            const Vec3 vec = {values[i], values[i + 1], values[i + 2]};
+            out.str("");
+            printer.print(vec);
+            ASSERT_EQ(referencePrint(vec, settings.widthBuffer, format), out.str()) << "values from " << i;
+
+            Mat33 mat;
+            copy(&values[i], &values[i + 9], &mat.col[0].x);
+            out.str("");
+            printer.print(mat);
+            ASSERT_EQ(referencePrint(mat, settings.widthBuffer, format), out.str()) << "values from " << i;
+        }
+    }
+}
+
+/**
+ * @brief Every SIMD level matches the scalar functions of math.hpp, bit for bit
+ *
+ */
+TEST_F(DifferentialTest, mathKernels)
+{
+    // odd count: every kernel runs its scalar tail too
+    vector<double> values = testValues(18 * 1001);
+    shuffle(values.begin(), values.end(), rng_);
+    const size_t count = values.size() / 18;
+    vector<Vec3> vecs1(count), vecs2(count);
+    vector<Mat33> mats1(count), mats2(count);
+    for (size_t i=0; i<count; i++)
+    {
+        const double* v = &values[18 * i];
+        vecs1[i] = {v[0], v[1], v[2]};
+        vecs2[i] = {v[3], v[4], v[5]};
+        copy(v, v + 9, &mats1[i].col[0].x);
+        copy(v + 9, v + 18, &mats2[i].col[0].x);
+    }
+
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        if (level > detectSimdLevel())
+        {
+            continue;
+        }
+        SCOPED_TRACE(simdLevelName(level));
+        const MathKernels& kernels = mathKernels(level);
+
+        vector<double> dots(count);
+        kernels.dotProducts(vecs1.data(), vecs2.data(), dots.data(), count);
+
+        vector<Mat33> transposed = mats1;
+        kernels.transposeMats(transposed.data(), count);
+
+        vector<Mat33> copies(count);
+        kernels.copyMats(mats1.data(), copies.data(), count);
+
+        vector<Mat33> products(count);
+        kernels.multiplyMats(mats1.data(), mats2.data(), products.data(), count);
+
+        // results aliasing the first operand
+        vector<Mat33> inPlace = mats1;
+        kernels.multiplyMats(inPlace.data(), mats2.data(), inPlace.data(), count);
+
+        for (size_t i=0; i<count; i++)
+        {
+            ASSERT_TRUE(sameResult(dotProduct(vecs1[i], vecs2[i]), dots[i])) << "dot " << i;
+
+            Mat33 expected = mats1[i];
+            transposeMat(expected);
+            ASSERT_TRUE(sameResult(expected, transposed[i])) << "transpose " << i;
+            ASSERT_TRUE(sameResult(copyMat(mats1[i]), copies[i])) << "copy " << i;
+
+            expected = multiplyMat(mats1[i], mats2[i]);
+            ASSERT_TRUE(sameResult(expected, products[i])) << "multiply " << i;
+            ASSERT_TRUE(sameResult(expected, inPlace[i])) << "multiply in place " << i;
+        }
+    }
+}
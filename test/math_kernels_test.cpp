@@ -0,0 +1,226 @@
+/// @file src/sarcos/math_kernels_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/math_kernels.hpp"
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Runs every SIMD variant available on the host against the scalar reference
+ * 
+ */
+class MathKernelsTest : public testing::TestWithParam<SimdLevel>
+{
+protected:
+
+    /**
+     * @brief Called before each test case
+     * 
+     */
+    void SetUp() override
+    {
+        if (GetParam() > detectSimdLevel())
+        {
+            GTEST_SKIP() << simdLevelName(GetParam()) << " not supported by this host";
+        }
+    }
+
+    /**
+     * @brief random value with a wide range of magnitudes and both signs
+     * 
+     * @return double 
+     */
+    double randomValue()
+    {
+        return uniform_real_distribution<double>(-1, 1)(rng_) * pow(10.0, uniform_int_distribution<int>(-8, 8)(rng_));
+    }
+
+    /**
+     * @brief random matrices
+     * 
+     * @param count - number of matrices
+     * @return vector<Mat33> 
+     */
+    vector<Mat33> randomMats(size_t count)
+    {
+        vector<Mat33> mats(count);
+        for (Mat33& mat : mats)
+        {
+            for (Vec3& col : mat.col)
+            {
+                col = {randomValue(), randomValue(), randomValue()};
+            }
+        }
+        return mats;
+    }
+
+    /**
+     * @brief expect two arrays of matrices to be bit-identical
+     * 
+     */
+    void expectEqual(const vector<Mat33>& expected, const vector<Mat33>& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i=0; i<expected.size(); i++)
+        {
+            for (int c=0; c<3; c++)
+            {
+                EXPECT_EQ(expected[i].col[c].x, actual[i].col[c].x) << "matrix " << i;
+                EXPECT_EQ(expected[i].col[c].y, actual[i].col[c].y) << "matrix " << i;
+                EXPECT_EQ(expected[i].col[c].z, actual[i].col[c].z) << "matrix " << i;
+            }
+        }
+    }
+
+    /// kernels under test
+    const MathKernels& kernels() { return mathKernels(GetParam()); }
+
+    /// scalar reference kernels
+    const MathKernels& reference() { return mathKernels(SimdLevel::Scalar); }
+
+    /// counts covering the vector loops and their scalar tails
+    const vector<size_t> counts_ = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 100};
+
+    /// fixed seed, reproducible inputs
+    mt19937_64 rng_{42};
+};
+
+/**
+ * @brief dot products match dotProduct() exactly
+ * 
+ */
+TEST_P(MathKernelsTest, dotProducts)
+{
+    for (size_t count : counts_)
+    {
+        vector<Vec3> vecs1(count), vecs2(count);
+        for (size_t i=0; i<count; i++)
+        {
+            vecs1[i] = {randomValue(), randomValue(), randomValue()};
+            vecs2[i] = {randomValue(), randomValue(), randomValue()};
+        }
+
+        vector<double> results(count);
+        kernels().dotProducts(vecs1.data(), vecs2.data(), results.data(), count);
+        for (size_t i=0; i<count; i++)
+        {
+            EXPECT_EQ(dotProduct(vecs1[i], vecs2[i]), results[i]) << "count " << count << ", pair " << i;
+        }
+    }
+}
+
+/**
+ * @brief in place transposes match transposeMat()
+ * 
+ */
+TEST_P(MathKernelsTest, transposeMats)
+{
+    for (size_t count : counts_)
+    {
+        vector<Mat33> expected = randomMats(count);
+        vector<Mat33> actual = expected;
+        reference().transposeMats(expected.data(), count);
+        kernels().transposeMats(actual.data(), count);
+        expectEqual(expected, actual);
+    }
+}
+
+/**
+ * @brief copies match the source
+ * 
+ */
+TEST_P(MathKernelsTest, copyMats)
+{
+    for (size_t count : counts_)
+    {
+        vector<Mat33> src = randomMats(count);
+        vector<Mat33> dst(count);
+        kernels().copyMats(src.data(), dst.data(), count);
+        expectEqual(src, dst);
+    }
+}
+
+/**
+ * @brief products match multiplyMat() exactly, also when the output aliases an input
+ * 
+ */
+TEST_P(MathKernelsTest, multiplyMats)
+{
+    for (size_t count : counts_)
+    {
+        vector<Mat33> mats1 = randomMats(count);
+        vector<Mat33> mats2 = randomMats(count);
+
+        vector<Mat33> expected(count);
+        for (size_t i=0; i<count; i++)
+        {
+            expected[i] = multiplyMat(mats1[i], mats2[i]);
+        }
+
+        vector<Mat33> actual(count);
+        kernels().multiplyMats(mats1.data(), mats2.data(), actual.data(), count);
+        expectEqual(expected, actual);
+
+        // in place, results written over either input
+        vector<Mat33> inPlace1 = mats1;
+        kernels().multiplyMats(inPlace1.data(), mats2.data(), inPlace1.data(), count);
+        expectEqual(expected, inPlace1);
+
+        vector<Mat33> inPlace2 = mats2;
+        kernels().multiplyMats(mats1.data(), inPlace2.data(), inPlace2.data(), count);
+        expectEqual(expected, inPlace2);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SimdLevels,
+    MathKernelsTest,
+    testing::Values(SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512),
+    [](const testing::TestParamInfo<SimdLevel>& info) { return string(simdLevelName(info.param)); });
+
+/**
+ * @brief SIMD level names round trip through parseSimdLevel()
+ * 
+ */
+TEST(SimdLevelTest, parseSimdLevel)
+{
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        SimdLevel parsed = SimdLevel::Scalar;
+        EXPECT_TRUE(parseSimdLevel(simdLevelName(level), parsed));
+        EXPECT_EQ(level, parsed);
+    }
+
+    SimdLevel parsed = SimdLevel::AVX2;
+    EXPECT_FALSE(parseSimdLevel("avx3", parsed));
+    EXPECT_EQ(SimdLevel::AVX2, parsed);
+}
+
+/**
+ * @brief the active level never exceeds what the host supports
+ * 
+ */
+TEST(SimdLevelTest, activeSimdLevel)
+{
+    EXPECT_LE(activeSimdLevel(), detectSimdLevel());
+}
+
+/**
+ * @brief a forced level only lowers the host level, an unknown name is reported
+ * 
+ */
+TEST(SimdLevelTest, resolveSimdLevel)
+{
+    ostringstream warnings;
+    EXPECT_EQ(SimdLevel::AVX2, resolveSimdLevel(SimdLevel::AVX2, nullptr, warnings));
+    EXPECT_EQ(SimdLevel::SSE2, resolveSimdLevel(SimdLevel::AVX2, "sse2", warnings));
+    EXPECT_EQ(SimdLevel::AVX2, resolveSimdLevel(SimdLevel::AVX2, "avx512", warnings));
+    EXPECT_EQ("", warnings.str());
+
+    EXPECT_EQ(SimdLevel::AVX2, resolveSimdLevel(SimdLevel::AVX2, "AVX", warnings));
+    EXPECT_NE(string::npos, warnings.str().find("unknown SARCOS_SIMD_LEVEL \"AVX\""));
+}
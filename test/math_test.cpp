@@ -136,4 +136,71 @@ TEST(MathTest, copyMat)
         EXPECT_EQ(mat.col[c].y, matCopy.col[c].y);
         EXPECT_EQ(mat.col[c].z, matCopy.col[c].z);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Multiply two 3x3 matrices and verify the result
+ * 
+ */
+TEST(MathTest, multiplyMat)
+{
+    // columns {1,2,3}, {4,5,6}, {7,8,9}
+    Mat33 mat1 = {{{1,2,3}, {4,5,6}, {7,8,9}}};
+
+    // identity leaves the matrix unchanged
+    Mat33 identity = {{{1,0,0}, {0,1,0}, {0,0,1}}};
+    Mat33 result = multiplyMat(mat1, identity);
+    for (int c=0; c<3; c++)
+    {
+        EXPECT_EQ(mat1.col[c].x, result.col[c].x);
+        EXPECT_EQ(mat1.col[c].y, result.col[c].y);
+        EXPECT_EQ(mat1.col[c].z, result.col[c].z);
+    }
+
+    // column 0 of the product is mat1 * {1,0,2} = col1 + 2 * col3
+    Mat33 mat2 = {{{1,0,2}, {0,-1,0}, {1,1,1}}};
+    result = multiplyMat(mat1, mat2);
+    EXPECT_EQ(15.0, result.col[0].x);
+    EXPECT_EQ(18.0, result.col[0].y);
+    EXPECT_EQ(21.0, result.col[0].z);
+
+    // column 1 is -col2
+    EXPECT_EQ(-4.0, result.col[1].x);
+    EXPECT_EQ(-5.0, result.col[1].y);
+    EXPECT_EQ(-6.0, result.col[1].z);
+
+    // column 2 is the sum of the columns
+    EXPECT_EQ(12.0, result.col[2].x);
+    EXPECT_EQ(15.0, result.col[2].y);
+    EXPECT_EQ(18.0, result.col[2].z);
+}
+
+/**
+ * @brief Batch operations match the single matrix/vector operations
+ * 
+ */
+TEST(MathTest, batchOperations)
+{
+    Vec3 vecs1[] = {{1,2,3}, {-4,5,6}, {0,0,1}};
+    Vec3 vecs2[] = {{4,5,6}, {1,1,1}, {2,3,4}};
+    double dots[3];
+    dotProducts(vecs1, vecs2, dots, 3);
+    EXPECT_EQ(32.0, dots[0]);
+    EXPECT_EQ(7.0, dots[1]);
+    EXPECT_EQ(4.0, dots[2]);
+
+    Mat33 mats[] = {{{{1,2,3}, {4,5,6}, {7,8,9}}}, {{{0,0,5}, {0,0,0}, {4,0,0}}}};
+    Mat33 copies[2];
+    copyMats(mats, copies, 2);
+    transposeMats(copies, 2);
+    EXPECT_EQ(4.0, copies[0].col[0].y);
+    EXPECT_EQ(2.0, copies[0].col[1].x);
+    EXPECT_EQ(5.0, copies[1].col[2].x);
+    EXPECT_EQ(4.0, copies[1].col[0].z);
+
+    Mat33 products[2];
+    multiplyMats(mats, copies, products, 2);
+    Mat33 expected = multiplyMat(mats[1], copies[1]);
+    EXPECT_EQ(expected.col[2].z, products[1].col[2].z);
+    EXPECT_EQ(expected.col[0].x, products[1].col[0].x);
+}
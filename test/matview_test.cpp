@@ -0,0 +1,91 @@
+/// @file src/sarcos/matview_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/matview.hpp"
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief Element access through a view matches the matrix layout
+ * 
+ */
+TEST(MatViewTest, elementAccess)
+{
+    const Mat33 mat = {{{1,2,3}, {4,5,6}, {7,8,9}}};
+    const MatView view(mat);
+
+    // (row, col) addresses col[col] component row
+    EXPECT_EQ(2.0, view(1, 0));
+    EXPECT_EQ(4.0, view(0, 1));
+    EXPECT_EQ(9.0, view(2, 2));
+
+    // the view reads the matrix in place
+    EXPECT_EQ(&mat.col[2].y, &view(1, 2));
+}
+
+/**
+ * @brief Row and column views use the expected strides
+ * 
+ */
+TEST(MatViewTest, rowsAndCols)
+{
+    const Mat33 mat = {{{1,2,3}, {4,5,6}, {7,8,9}}};
+    const MatView view(mat);
+
+    MatLineView row = view.row(1);
+    EXPECT_EQ(3, row.stride());
+    EXPECT_EQ(2.0, row[0]);
+    EXPECT_EQ(5.0, row[1]);
+    EXPECT_EQ(8.0, row[2]);
+
+    MatLineView col = view.col(2);
+    EXPECT_EQ(1, col.stride());
+    EXPECT_EQ(7.0, col[0]);
+    EXPECT_EQ(8.0, col[1]);
+    EXPECT_EQ(9.0, col[2]);
+}
+
+/**
+ * @brief A transposed view matches transposeMat without modifying the matrix
+ * 
+ */
+TEST(MatViewTest, transposed)
+{
+    const Mat33 mat = {{{1,2,3.5}, {4,5,6.65}, {7,8,9}}};
+    Mat33 matT = copyMat(mat);
+    transposeMat(matT);
+
+    const MatView view = MatView(mat).transposed();
+    EXPECT_TRUE(view.isTransposed());
+    for (int r=0; r<3; r++)
+    {
+        for (int c=0; c<3; c++)
+        {
+            EXPECT_EQ(MatView(matT)(r, c), view(r, c));
+        }
+    }
+
+    // transposing twice gives the original view back
+    EXPECT_EQ(&mat.col[0].y, &view.transposed()(1, 0));
+}
+
+/**
+ * @brief Iterate over rows and columns with standard algorithms
+ * 
+ */
+TEST(MatViewTest, iterators)
+{
+    const Mat33 mat = {{{1,2,3}, {4,5,6}, {7,8,9}}};
+    const MatView view(mat);
+
+    std::vector<double> row(view.row(0).begin(), view.row(0).end());
+    EXPECT_EQ(std::vector<double>({1,4,7}), row);
+
+    std::vector<double> col(view.col(1).begin(), view.col(1).end());
+    EXPECT_EQ(std::vector<double>({4,5,6}), col);
+
+    MatLineView line = view.row(2);
+    EXPECT_EQ(3, line.end() - line.begin());
+    EXPECT_EQ(9.0, *std::max_element(line.begin(), line.end()));
+    EXPECT_EQ(6.0, line.begin()[1]);
+}
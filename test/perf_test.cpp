@@ -0,0 +1,397 @@
+/// @file src/sarcos/perf_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/cachedmat.hpp"
+#include "sarcos/math.hpp"
+#include "sarcos/prettyprinter.hpp"
+#include "sarcos/reduce.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Checked-in baseline of every workload, in nanoseconds per operation
+ *
+ * Location is taken from the SARCOS_PERF_BASELINE environment variable,
+ * or the file checked in next to this test.
+ *
+ * With SARCOS_PERF_UPDATE=1 the measured values are written back to the
+ * baseline file instead of being compared against it. Otherwise the file is
+ * never written, and a workload missing from it is skipped.
+ *
+ * The file records the build it was measured with (build type and compiler,
+ * SARCOS_PERF_BUILD). A build that does not match skips every comparison:
+ * timings of an unoptimized build say nothing about a regression.
+ */
+class PerfBaseline : public testing::Environment
+{
+public:
+    /**
+     * @brief load the baseline file
+     *
+     */
+    void SetUp() override
+    {
+        const char* path = getenv("SARCOS_PERF_BASELINE");
+        path_ = path ? path : SARCOS_PERF_BASELINE_FILE;
+
+        const char* update = getenv("SARCOS_PERF_UPDATE");
+        update_ = update && string(update) == "1";
+
+        // allowed slowdown relative to the baseline, 1.0 == up to twice as slow
+        const char* tolerance = getenv("SARCOS_PERF_TOLERANCE");
+        tolerance_ = tolerance ? strtod(tolerance, nullptr) : 1.0;
+
+        ifstream file(path_);
+        string line;
+        while (getline(file, line))
+        {
+            // skip comments and blank lines
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+            stringstream ss(line);
+            string name;
+            double nsPerOp;
+            if (line.compare(0, kBuildKey.size(), kBuildKey) == 0)
+            {
+                build_ = line.substr(kBuildKey.size());
+            }
+            else if (ss >> name >> nsPerOp)
+            {
+                values_[name] = nsPerOp;
+            }
+        }
+    }
+
+    /**
+     * @brief write the measured values back, if requested
+     *
+     */
+    void TearDown() override
+    {
+        if (!update_)
+        {
+            return;
+        }
+        ofstream file(path_);
+        file << "# Performance baseline, nanoseconds per operation.\n"
+             << "# Values depend on the machine and build type they were recorded with.\n"
+             << "# Regenerate with: SARCOS_PERF_UPDATE=1 make perf\n"
+             << kBuildKey << SARCOS_PERF_BUILD << "\n";
+        for (const auto& entry : values_)
+        {
+            file << entry.first << " " << entry.second << "\n";
+        }
+    }
+
+    /**
+     * @brief compare a measurement against the baseline
+     *
+     * @param name - workload name
+     * @param nsPerOp - measured nanoseconds per operation
+     */
+    void check(const string& name, double nsPerOp)
+    {
+        cout << name << ": " << nsPerOp << " ns/op";
+
+        if (update_)
+        {
+            cout << " (recorded)" << endl;
+            values_[name] = nsPerOp;
+            return;
+        }
+
+        if (build_ != SARCOS_PERF_BUILD)
+        {
+            cout << endl;
+            GTEST_SKIP() << "the baseline in " << path_ << " was recorded with the build \""
+                         << build_ << "\", this is \"" << SARCOS_PERF_BUILD << "\"";
+        }
+
+        auto baseline = values_.find(name);
+        if (baseline == values_.end())
+        {
+            cout << endl;
+            GTEST_SKIP() << name << " has no baseline in " << path_
+                         << ", record it with SARCOS_PERF_UPDATE=1";
+        }
+
+        cout << " (baseline " << baseline->second << " ns/op)" << endl;
+        EXPECT_LE(nsPerOp, baseline->second * (1.0 + tolerance_))
+            << name << " regressed beyond the tolerance of " << tolerance_
+            << ", see " << path_;
+    }
+
+private:
+    /// prefix of the line recording the build of the baseline
+    const string kBuildKey = "build ";
+
+    /// baseline file
+    string path_;
+
+    /// build type and compiler the baseline was recorded with
+    string build_;
+
+    /// workload name -> nanoseconds per operation
+    map<string, double> values_;
+
+    /// allowed relative slowdown
+    double tolerance_;
+
+    /// rewrite the baseline instead of comparing
+    bool update_;
+};
+
+/// global baseline, owned by gtest once registered
+static PerfBaseline* g_baseline = static_cast<PerfBaseline*>(
+    testing::AddGlobalTestEnvironment(new PerfBaseline()));
+
+/**
+ * @brief stream buffer discarding everything written to it
+ *
+ */
+class NullBuffer : public streambuf
+{
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+/**
+ * @brief All performance regression workloads
+ *
+ */
+class PerfTest : public testing::Test
+{
+protected:
+
+    /**
+     * @brief run a workload several times, keep the fastest run
+     *
+     * @param numOps - number of operations performed by one run of the workload
+     * @param workload - the workload
+     * @return double - nanoseconds per operation
+     */
+    template <typename Workload>
+    double measure(size_t numOps, Workload workload)
+    {
+        double best = numeric_limits<double>::max();
+        for (int r=0; r<repetitions_; r++)
+        {
+            auto start = chrono::steady_clock::now();
+            workload();
+            auto stop = chrono::steady_clock::now();
+            best = min(best, chrono::duration<double, nano>(stop - start).count());
+        }
+        return best / numOps;
+    }
+
+    /**
+     * @brief redirect stdout to a null sink
+     *
+     */
+    void startNullSink()
+    {
+        p_stdout_ = cout.rdbuf(&nullBuffer_);
+    }
+
+    /**
+     * @brief restore stdout
+     *
+     */
+    void stopNullSink()
+    {
+        cout.rdbuf(p_stdout_);
+    }
+
+    /// number of runs per workload
+    const int repetitions_ = 3;
+
+    /// sink for printed output
+    NullBuffer nullBuffer_;
+
+    /// original stdout buffer
+    streambuf* p_stdout_ = nullptr;
+};
+
+/**
+ * @brief 1e6 dot products
+ *
+ */
+TEST_F(PerfTest, dotProduct_1e6)
+{
+    const size_t numOps = 1000000;
+
+    // a small set of vectors, reused to stay in cache
+    vector<Vec3> vecs(1024);
+    for (size_t i=0; i<vecs.size(); i++)
+    {
+        vecs[i] = {i * 0.5, -1.0 * i, i + 3.25};
+    }
+
+    volatile double sink = 0;
+    double nsPerOp = measure(numOps, [&]()
+    {
+        double sum = 0;
+        for (size_t i=0; i<numOps; i++)
+        {
+            sum += dotProduct(vecs[i % vecs.size()], vecs[(i + 1) % vecs.size()]);
+        }
+        sink = sum;
+    });
+
+    g_baseline->check("dotProduct_1e6", nsPerOp);
+}
+
+/**
+ * @brief 1e5 matrix prints to a null sink
+ *
+ */
+TEST_F(PerfTest, printMat33_1e5)
+{
+    const size_t numOps = 100000;
+    PrettyPrinter printer;
+    const Mat33 mat = {{{1,-2,13}, {4,-5.4,6}, {7.23,800,-9}}};
+
+    startNullSink();
+    double nsPerOp = measure(numOps, [&]()
+    {
+        for (size_t i=0; i<numOps; i++)
+        {
+            printer.print(mat);
+        }
+    });
+    stopNullSink();
+
+    g_baseline->check("printMat33_1e5", nsPerOp);
+}
+
+/**
+ * @brief 1e5 prints of an unchanged matrix with a cached layout, to a null sink
+ *
+ */
+TEST_F(PerfTest, printCachedMat33_1e5)
+{
+    const size_t numOps = 100000;
+    PrettyPrinter printer;
+    const CachedMat33 mat(Mat33{{{1,-2,13}, {4,-5.4,6}, {7.23,800,-9}}});
+
+    startNullSink();
+    double nsPerOp = measure(numOps, [&]()
+    {
+        for (size_t i=0; i<numOps; i++)
+        {
+            printer.print(mat);
+        }
+    });
+    stopNullSink();
+
+    g_baseline->check("printCachedMat33_1e5", nsPerOp);
+}
+
+/**
+ * @brief print a deep chain of nodes to a null sink
+ *
+ */
+TEST_F(PerfTest, printNodeChain_1e4)
+{
+    const size_t numNodes = 10000;
+    PrettyPrinter printer;
+
+    // link the nodes into a single chain
+    vector<Node> nodes(numNodes);
+    for (size_t i=0; i<numNodes; i++)
+    {
+        nodes[i].data = {{{1.0*i,2,3}, {4,5,6}, {7,8,-9.5}}};
+        nodes[i].children = (i + 1 < numNodes) ? &nodes[i + 1] : nullptr;
+        nodes[i].numChildren = numNodes - i - 1;
+    }
+
+    startNullSink();
+    double nsPerOp = measure(numNodes, [&]()
+    {
+        printer.print(&nodes[0]);
+    });
+    stopNullSink();
+
+    g_baseline->check("printNodeChain_1e4", nsPerOp);
+}
+
+/**
+ * @brief compensated sum of 1e6 values, against a naive loop
+ *
+ */
+TEST_F(PerfTest, sumValues_1e6)
+{
+    const size_t numOps = 1000000;
+    vector<double> values(numOps);
+    for (size_t i=0; i<numOps; i++)
+    {
+        values[i] = (i % 7) * 0.1 - 0.3;
+    }
+
+    volatile double sink = 0;
+    double naiveNsPerOp = measure(numOps, [&]()
+    {
+        double sum = 0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        sink = sum;
+    });
+    double nsPerOp = measure(numOps, [&]()
+    {
+        sink = sumValues(values.data(), values.size());
+    });
+
+    cout << "compensated / naive: " << nsPerOp / naiveNsPerOp << endl;
+    g_baseline->check("naiveSum_1e6", naiveNsPerOp);
+    g_baseline->check("sumValues_1e6", nsPerOp);
+}
+
+/**
+ * @brief compensated sum of 1e6 dot products, against a naive loop
+ *
+ */
+TEST_F(PerfTest, sumDotProducts_1e6)
+{
+    const size_t numOps = 1000000;
+    vector<Vec3> vecs1(numOps), vecs2(numOps);
+    for (size_t i=0; i<numOps; i++)
+    {
+        vecs1[i] = {i * 0.5, -1.0 * i, i + 3.25};
+        vecs2[i] = {0.1, (i % 5) * 0.2, -0.3};
+    }
+
+    volatile double sink = 0;
+    double naiveNsPerOp = measure(numOps, [&]()
+    {
+        double sum = 0;
+        for (size_t i=0; i<numOps; i++)
+        {
+            sum += dotProduct(vecs1[i], vecs2[i]);
+        }
+        sink = sum;
+    });
+    double nsPerOp = measure(numOps, [&]()
+    {
+        sink = sumDotProducts(vecs1.data(), vecs2.data(), numOps);
+    });
+
+    cout << "compensated / naive: " << nsPerOp / naiveNsPerOp << endl;
+    g_baseline->check("naiveDotSum_1e6", naiveNsPerOp);
+    g_baseline->check("sumDotProducts_1e6", nsPerOp);
+}
@@ -0,0 +1,192 @@
+/// @file src/sarcos/pipeline_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/pipeline.hpp"
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    /**
+     * @brief batches of consecutive integers
+     *
+     */
+    Generator<vector<int>> countBatches(int numBatches, int batchSize)
+    {
+        for (int b=0; b<numBatches; b++)
+        {
+            vector<int> batch(batchSize);
+            for (int i=0; i<batchSize; i++)
+            {
+                batch[i] = b * batchSize + i;
+            }
+            co_yield batch;
+        }
+    }
+
+    /**
+     * @brief throws when asked for the batch at index failAt
+     *
+     */
+    Generator<vector<int>> failingBatches(int failAt)
+    {
+        for (int b=0; ; b++)
+        {
+            if (b == failAt)
+            {
+                throw runtime_error("source failed");
+            }
+            co_yield vector<int>(1, b);
+        }
+    }
+}
+
+/**
+ * @brief A generator yields its values in order, then ends
+ *
+ */
+TEST(PipelineTest, generator)
+{
+    Generator<vector<int>> batches = countBatches(3, 2);
+    for (int b=0; b<3; b++)
+    {
+        optional<vector<int>> batch = batches.next();
+        ASSERT_TRUE(batch.has_value());
+        EXPECT_EQ(vector<int>({2*b, 2*b + 1}), *batch);
+    }
+    EXPECT_FALSE(batches.next().has_value());
+    EXPECT_FALSE(batches.next().has_value());
+
+    Generator<vector<int>> failing = failingBatches(1);
+    EXPECT_TRUE(failing.next().has_value());
+    EXPECT_THROW(failing.next(), runtime_error);
+    EXPECT_FALSE(failing.next().has_value());
+}
+
+/**
+ * @brief Batches keep their order through the stages, on any number of threads
+ *
+ */
+TEST(PipelineTest, order)
+{
+    for (unsigned int threads : {1u, 2u, 4u})
+    {
+        for (size_t capacity : {size_t(1), size_t(4)})
+        {
+            Generator<vector<int>> batches = countBatches(200, 5);
+            vector<int> output;
+            PipelineOptions options;
+            options.threads = threads;
+            options.channelCapacity = capacity;
+            PipelineStats stats = runPipeline(batches,
+                [](vector<int>& batch) { for (int& value : batch) value *= 2; },
+                [&](vector<int>& batch) { output.insert(output.end(), batch.begin(), batch.end()); },
+                options);
+
+            ASSERT_EQ(1000u, output.size());
+            for (int i=0; i<1000; i++)
+            {
+                ASSERT_EQ(2 * i, output[i]) << threads << " threads, capacity " << capacity;
+            }
+
+            ASSERT_EQ(3u, stats.stages.size());
+            EXPECT_EQ("read", stats.stages[0].name);
+            EXPECT_EQ("transform", stats.stages[1].name);
+            EXPECT_EQ("write", stats.stages[2].name);
+            for (const StageStats& stage : stats.stages)
+            {
+                EXPECT_EQ(200u, stage.batches);
+                EXPECT_EQ(1000u, stage.items);
+            }
+        }
+    }
+}
+
+/**
+ * @brief A slow sink makes the earlier stages wait instead of queueing without bound
+ *
+ */
+TEST(PipelineTest, backpressure)
+{
+    Generator<vector<int>> batches = countBatches(20, 1);
+    atomic<int> inFlight(0);
+    int maxInFlight = 0;
+    PipelineOptions options;
+    options.channelCapacity = 1;
+    PipelineStats stats = runPipeline(batches,
+        [&](vector<int>&) { maxInFlight = max(maxInFlight, ++inFlight); },
+        [&](vector<int>&)
+        {
+            inFlight--;
+            this_thread::sleep_for(chrono::milliseconds(2));
+        },
+        options);
+
+    // at most: one in each channel, one moving through the transform, one in the sink
+    EXPECT_LE(maxInFlight, 3);
+    EXPECT_GT(stats.stages[0].waits + stats.stages[1].waits, 0u);
+    EXPECT_EQ(20u, stats.stages[2].items);
+}
+
+/**
+ * @brief An exception in any stage stops the others and reaches the caller
+ *
+ */
+TEST(PipelineTest, exceptions)
+{
+    PipelineOptions options;
+    options.channelCapacity = 1;
+
+    Generator<vector<int>> failing = failingBatches(50);
+    EXPECT_THROW(runPipeline(failing, [](vector<int>&) {}, [](vector<int>&) {}, options), runtime_error);
+
+    Generator<vector<int>> batches = countBatches(1000, 1);
+    EXPECT_THROW(runPipeline(batches,
+        [](vector<int>& batch) { if (batch[0] == 10) throw invalid_argument("transform failed"); },
+        [](vector<int>&) {},
+        options), invalid_argument);
+
+    Generator<vector<int>> more = countBatches(1000, 1);
+    EXPECT_THROW(runPipeline(more,
+        [](vector<int>&) {},
+        [](vector<int>& batch) { if (batch[0] == 10) throw out_of_range("sink failed"); },
+        options), out_of_range);
+}
+
+/**
+ * @brief Closing a channel fails the sends and drains the receives
+ *
+ */
+TEST(PipelineTest, channelClose)
+{
+    ThreadPool pool(1);
+    EXPECT_THROW(Channel<int>(0, pool), invalid_argument);
+
+    Channel<int> channel(2, pool);
+    vector<int> received;
+    bool sentAfterClose = true;
+    auto run = [&]() -> Task
+    {
+        co_await channel.send(1);
+        co_await channel.send(2);
+        channel.close();
+        sentAfterClose = co_await channel.send(3);
+        while (optional<int> value = co_await channel.receive())
+        {
+            received.push_back(*value);
+        }
+    };
+    Task task = run();
+    task.start(pool);
+    task.wait();
+
+    EXPECT_FALSE(sentAfterClose);
+    EXPECT_EQ(vector<int>({1, 2}), received);
+    EXPECT_EQ(0u, channel.sendWaits());
+    EXPECT_EQ(0u, channel.receiveWaits());
+}
@@ -2,7 +2,11 @@
 
 #include <gtest/gtest.h>
 #include "sarcos/prettyprinter.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <limits>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 using namespace std;
 
@@ -143,6 +147,163 @@ TEST_F(PrettyPrinterTest, printVec3_Mixed)
     EXPECT_EQ("[ 55.750  -88.000  -4000.000 ]\n\n", getCapture());
 }
 
+/**
+ * @brief NaN and infinity print as fixed width tokens
+ * 
+ */
+TEST_F(PrettyPrinterTest, printVec3_NanInf)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    // right aligned to the longest token, "-inf"
+    Vec3 vec = {nan, inf, -inf};
+    p_printer_->print(vec);
+    EXPECT_EQ("[  nan   inf  -inf ]\n\n", getCapture());
+
+    // the sign of a NaN and the precision do not change the token
+    p_printer_->setPrecision(8);
+    EXPECT_EQ(" nan", p_printer_->format(-nan));
+    EXPECT_EQ(4, p_printer_->computeStrSize(nan));
+
+    // custom tokens
+    FormatPolicy policy;
+    policy.nanToken = "NaN";
+    policy.posInfToken = "+Inf";
+    policy.negInfToken = "-Infinity";
+    p_printer_->setFormatPolicy(policy);
+    EXPECT_EQ("      NaN", p_printer_->format(nan));
+    EXPECT_EQ("     +Inf", p_printer_->format(inf));
+    EXPECT_EQ("-Infinity", p_printer_->format(-inf));
+
+    // cut to the max width
+    policy.maxWidth = 3;
+    p_printer_->setFormatPolicy(policy);
+    EXPECT_EQ("NaN", p_printer_->format(nan));
+    EXPECT_EQ("+In", p_printer_->format(inf));
+    EXPECT_EQ("-In", p_printer_->format(-inf));
+}
+
+/**
+ * @brief Huge values fall back to scientific notation
+ * 
+ */
+TEST_F(PrettyPrinterTest, printVec3_Huge)
+{
+    Vec3 vec = {1e300, -2.5e15, 1};
+    p_printer_->print(vec);
+    EXPECT_EQ("[ 1.000e+300  -2.500e+15  1.000 ]\n\n", getCapture());
+
+    // lower threshold
+    FormatPolicy policy;
+    policy.sciThreshold = 1000;
+    p_printer_->setFormatPolicy(policy);
+    EXPECT_EQ("999.000", p_printer_->format(999));
+    EXPECT_EQ("1.000e+03", p_printer_->format(1000));
+    EXPECT_EQ("-1.000e+03", p_printer_->format(-1000));
+}
+
+/**
+ * @brief Formatted values never exceed the max width
+ * 
+ */
+TEST_F(PrettyPrinterTest, format_MaxWidth)
+{
+    FormatPolicy policy;
+    policy.maxWidth = 8;
+    p_printer_->setFormatPolicy(policy);
+
+    // fits in fixed point notation
+    EXPECT_EQ("1234.000", p_printer_->format(1234));
+
+    // too wide: scientific notation with fewer decimal places
+    EXPECT_EQ("1.23e+04", p_printer_->format(12345));
+    EXPECT_EQ("-1.2e+04", p_printer_->format(-12345));
+
+    // high precision is capped by the width as well
+    p_printer_->setPrecision(12);
+    EXPECT_GE(8, p_printer_->computeStrSize(3.14159));
+    EXPECT_GE(8, p_printer_->computeStrSize(-1e300));
+
+    // formats only, nothing printed
+    EXPECT_EQ("", getCapture());
+}
+
+/**
+ * @brief Values that do not fit even without decimal places print as overflow fill
+ * 
+ */
+TEST_F(PrettyPrinterTest, format_Overflow)
+{
+    FormatPolicy policy;
+    policy.maxWidth = 5;
+    p_printer_->setFormatPolicy(policy);
+
+    // the exponent alone is 5 or 6 characters wide
+    EXPECT_EQ("1e+04", p_printer_->format(12345));
+    EXPECT_EQ("#####", p_printer_->format(2e300));
+    EXPECT_EQ("#####", p_printer_->format(-1e4));
+    EXPECT_EQ("9.500", p_printer_->format(9.5));
+
+    // rounding carries into a 3 digit exponent, fewer decimal places still fit
+    policy.maxWidth = 7;
+    policy.sciThreshold = 1;
+    p_printer_->setFormatPolicy(policy);
+    p_printer_->setPrecision(2);
+    EXPECT_EQ("1e+100", p_printer_->format(9.96e99));
+    EXPECT_EQ("-1e+100", p_printer_->format(-9.995e99));
+    EXPECT_EQ("9.9e+99", p_printer_->format(9.94e99));
+    p_printer_->setPrecision(3);
+
+    policy.sciThreshold = FormatPolicy().sciThreshold;
+    policy.maxWidth = 1;
+    policy.overflowFill = '*';
+    p_printer_->setFormatPolicy(policy);
+    EXPECT_EQ("*", p_printer_->format(3.14159));
+    EXPECT_EQ("i", p_printer_->format(std::numeric_limits<double>::infinity()));
+
+    // below 1 is treated as 1
+    policy.maxWidth = 0;
+    p_printer_->setFormatPolicy(policy);
+    EXPECT_EQ("*", p_printer_->format(3.14159));
+    EXPECT_EQ(1, p_printer_->computeStrSize(-2e300));
+
+    // formats only, nothing printed
+    EXPECT_EQ("", getCapture());
+}
+
+/**
+ * @brief A negative precision prints 6 decimal places, as iostream does
+ * 
+ */
+TEST_F(PrettyPrinterTest, format_NegativePrecision)
+{
+    p_printer_->setPrecision(-1);
+    EXPECT_EQ("3.141590", p_printer_->format(3.14159));
+    EXPECT_EQ("-2.000000", p_printer_->format(-2));
+
+    // more decimal places than the default max width fall back to scientific notation
+    p_printer_->setPrecision(40);
+    EXPECT_EQ(24, p_printer_->computeStrSize(1.0 / 3));
+
+    // formats only, nothing printed
+    EXPECT_EQ("", getCapture());
+}
+
+/**
+ * @brief Denormal and tiny values format like any small value
+ * 
+ */
+TEST_F(PrettyPrinterTest, format_Denormal)
+{
+    EXPECT_EQ("0.000", p_printer_->format(std::numeric_limits<double>::denorm_min()));
+    EXPECT_EQ("-0.000", p_printer_->format(-1e-310));
+    EXPECT_EQ("0.000", p_printer_->format(1e-300));
+
+    // formats only, nothing printed
+    EXPECT_EQ("", getCapture());
+}
+
 /**
  * @brief Print a 3x3 matrix with desired precision
  * 
@@ -235,6 +396,27 @@ TEST_F(PrettyPrinterTest, printMat33_Mixed)
               "\n", getCapture());
 }
 
+/**
+ * @brief Print a transposed view of a const matrix
+ * 
+ */
+TEST_F(PrettyPrinterTest, printMatView_Transposed)
+{
+    const Mat33 mat = {{{1,2543,-3}, {-4123,5,-6}, {75.6,-8,-9}}};
+
+    // print the transpose without copying the matrix
+    p_printer_->print(MatView(mat).transposed());
+    string viewCapture = getCapture();
+
+    // reference: print a transposed copy
+    startCapture();
+    Mat33 matCopy = copyMat(mat);
+    transposeMat(matCopy);
+    p_printer_->print(matCopy);
+
+    EXPECT_EQ(getCapture(), viewCapture);
+}
+
 /**
  * @brief Print a Node that points to no children.
  * This print should be identical to a matrix print,
@@ -325,4 +507,40 @@ TEST_F(PrettyPrinterTest, printNodeChildren)
     node2 = nullptr;
     delete node3;
     node3 = nullptr;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Print every node of a built tree, siblings included
+ * 
+ */
+TEST_F(PrettyPrinterTest, printBuiltTree)
+{
+    // 0 -> {1 -> {3}, 2}, preorder 0 1 3 2
+    vector<Mat33> data;
+    for (int i=0; i<4; i++)
+    {
+        data.push_back({{{double(i),0,0}, {0,1,0}, {0,0,1}}});
+    }
+    vector<int> parents = {-1, 0, 0, 1};
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+
+    p_printer_->print(root, data.size());
+
+    const string arrow = "   |\nChildren\n   |\n   V\n\n";
+    auto mat = [](int i)
+    {
+        return "[ " + to_string(i) + ".000  0.000  0.000 ]\n"
+               "[ 0.000  1.000  0.000 ]\n"
+               "[ 0.000  0.000  1.000 ]\n\n";
+    };
+    EXPECT_EQ("Node 0 data:\n" + mat(0) + arrow +
+              "Node 1 data (child of node 0):\n" + mat(1) + arrow +
+              "Node 2 data (child of node 1):\n" + mat(3) +
+              "Node 3 data (child of node 0):\n" + mat(2), getCapture());
+
+    // a hand-linked node is not a built tree
+    Node node = {data[0], nullptr, 1};
+    EXPECT_THROW(p_printer_->print(&node, 2), invalid_argument);
+
+    destroyTree(root);
+}
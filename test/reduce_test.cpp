@@ -0,0 +1,232 @@
+/// @file src/sarcos/reduce_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/reduce.hpp"
+#include "sarcos/treebuilder.hpp"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief All tests for the compensated reductions
+ * 
+ */
+class ReduceTest : public testing::Test
+{
+protected:
+
+    /**
+     * @brief Called before each test case
+     * 
+     */
+    void SetUp() override
+    {
+        // enough values to spread over several threads, with a partial last block
+        const size_t count = 300001;
+        mt19937_64 rng(3);
+        uniform_real_distribution<double> mantissa(-1, 1);
+        uniform_int_distribution<int> exponent(-20, 20);
+
+        values_.resize(count);
+        for (double& value : values_)
+        {
+            value = ldexp(mantissa(rng), exponent(rng));
+        }
+
+        vecs1_.resize(count / 3);
+        vecs2_.resize(count / 3);
+        memcpy(vecs1_.data(), values_.data(), vecs1_.size() * sizeof(Vec3));
+        memcpy(vecs2_.data(), values_.data() + 1, vecs2_.size() * sizeof(Vec3));
+
+        mats_.resize(count / 9);
+        memcpy(mats_.data(), values_.data(), mats_.size() * sizeof(Mat33));
+    }
+
+    /**
+     * @brief all combinations of threads and SIMD levels to compare
+     * 
+     * @return vector<ReduceOptions> 
+     */
+    vector<ReduceOptions> allOptions()
+    {
+        vector<ReduceOptions> options;
+        for (unsigned int threads : {1u, 2u, 3u, 8u})
+        {
+            for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512})
+            {
+                ReduceOptions option;
+                option.threads = threads;
+                option.maxSimdLevel = level;
+                options.push_back(option);
+            }
+        }
+        return options;
+    }
+
+    /// random values over a wide range of magnitudes
+    vector<double> values_;
+
+    /// the same values as vectors
+    vector<Vec3> vecs1_, vecs2_;
+
+    /// the same values as matrices
+    vector<Mat33> mats_;
+};
+
+/**
+ * @brief Compensation recovers what a naive sum loses
+ * 
+ */
+TEST_F(ReduceTest, compensated)
+{
+    vector<double> values = {1e16, 1, -1e16, 1, 1e-3};
+    EXPECT_EQ(2.001, sumValues(values.data(), values.size()));
+
+    // 0.1 is inexact, 1e6 additions drift when summed naively
+    vector<double> tenths(1000000, 0.1);
+    double naive = 0;
+    for (double value : tenths)
+    {
+        naive += value;
+    }
+    EXPECT_NE(100000.0, naive);
+    EXPECT_EQ(100000.0, sumValues(tenths.data(), tenths.size()));
+
+    EXPECT_EQ(0.0, sumValues(values.data(), 0));
+    EXPECT_EQ(5.0, normValues(vector<double>({3, 4}).data(), 2));
+}
+
+/**
+ * @brief Results are bit-identical for any number of threads and SIMD level
+ * 
+ */
+TEST_F(ReduceTest, deterministic)
+{
+    ReduceOptions reference;
+    reference.threads = 1;
+    reference.maxSimdLevel = SimdLevel::Scalar;
+
+    const double sum = sumValues(values_.data(), values_.size(), reference);
+    const double norm = normValues(values_.data(), values_.size(), reference);
+    const double dots = sumDotProducts(vecs1_.data(), vecs2_.data(), vecs1_.size(), reference);
+    const double traces = sumTraces(mats_.data(), mats_.size(), reference);
+    const Mat33 mats = sumMats(mats_.data(), mats_.size(), reference);
+
+    for (const ReduceOptions& options : allOptions())
+    {
+        SCOPED_TRACE(string("threads ") + to_string(options.threads) + ", " + simdLevelName(options.maxSimdLevel));
+        EXPECT_EQ(sum, sumValues(values_.data(), values_.size(), options));
+        EXPECT_EQ(norm, normValues(values_.data(), values_.size(), options));
+        EXPECT_EQ(dots, sumDotProducts(vecs1_.data(), vecs2_.data(), vecs1_.size(), options));
+        EXPECT_EQ(traces, sumTraces(mats_.data(), mats_.size(), options));
+        Mat33 actual = sumMats(mats_.data(), mats_.size(), options);
+        EXPECT_EQ(0, memcmp(&mats, &actual, sizeof(Mat33)));
+    }
+}
+
+/**
+ * @brief Reductions match an exact reference closely
+ * 
+ */
+TEST_F(ReduceTest, accuracy)
+{
+    // long double accumulation as reference
+    long double sum = 0, squares = 0;
+    for (double value : values_)
+    {
+        sum += value;
+        squares += (long double)value * value;
+    }
+    EXPECT_NEAR(double(sum), sumValues(values_.data(), values_.size()), fabs(double(sum)) * 1e-15);
+    EXPECT_NEAR(sqrt(double(squares)), normValues(values_.data(), values_.size()), sqrt(double(squares)) * 1e-15);
+
+    // elements of the matrices are the leading values
+    long double element4 = 0;
+    for (const Mat33& mat : mats_)
+    {
+        element4 += mat.col[1].y;
+    }
+    EXPECT_NEAR(double(element4), sumMats(mats_.data(), mats_.size()).col[1].y, fabs(double(element4)) * 1e-15);
+}
+
+/**
+ * @brief Infinity, NaN and overflow give what a naive sum gives, never NaN from the compensation
+ * 
+ */
+TEST_F(ReduceTest, nonFinite)
+{
+    const double inf = numeric_limits<double>::infinity();
+    for (const ReduceOptions& options : allOptions())
+    {
+        vector<double> values = {1, inf, 2};
+        EXPECT_EQ(inf, sumValues(values.data(), values.size(), options));
+        values = {1e308, 1e308};
+        EXPECT_EQ(inf, sumValues(values.data(), values.size(), options));
+        values = {-1e308, -1e308, 1};
+        EXPECT_EQ(-inf, sumValues(values.data(), values.size(), options));
+        values = {inf, 1, -inf};
+        EXPECT_TRUE(std::isnan(sumValues(values.data(), values.size(), options)));
+
+        // in the SIMD lanes and in later blocks
+        values = values_;
+        values[5] = inf;
+        values[200000] = 1e308;
+        EXPECT_EQ(inf, sumValues(values.data(), values.size(), options));
+        values[100] = NAN;
+        EXPECT_TRUE(std::isnan(sumValues(values.data(), values.size(), options)));
+
+        // squares beyond the range of double: scaled, as hypot
+        values = {1e200, 1e200};
+        EXPECT_DOUBLE_EQ(hypot(1e200, 1e200), normValues(values.data(), values.size(), options));
+        values = {3e-200, -4e-200};
+        EXPECT_DOUBLE_EQ(5e-200, normValues(values.data(), values.size(), options));
+        values = {DBL_MAX, DBL_MAX / 2};
+        EXPECT_DOUBLE_EQ(hypot(DBL_MAX / 2, DBL_MAX / 2) * sqrt(2.5), normValues(values.data(), values.size(), options));
+        values = {NAN, 1};
+        EXPECT_TRUE(std::isnan(normValues(values.data(), values.size(), options)));
+        values = {NAN, -inf};
+        EXPECT_EQ(inf, normValues(values.data(), values.size(), options));
+
+        vector<Mat33> mats = mats_;
+        mats[10].col[1].y = inf;
+        mats[20000].col[2].z = -1e308;
+        mats[20001].col[2].z = -1e308;
+        const Mat33 sum = sumMats(mats.data(), mats.size(), options);
+        EXPECT_EQ(inf, sum.col[1].y);
+        EXPECT_EQ(-inf, sum.col[2].z);
+        EXPECT_TRUE(std::isfinite(sum.col[0].x));
+        EXPECT_EQ(inf, sumTraces(mats.data(), 100, options));
+        EXPECT_EQ(inf, normMats(mats.data(), mats.size(), options));
+    }
+}
+
+/**
+ * @brief Tree reductions match the reductions over the same matrices
+ * 
+ */
+TEST_F(ReduceTest, tree)
+{
+    // a chain, node data in preorder == mats_
+    vector<int> parents(mats_.size());
+    for (size_t i=0; i<parents.size(); i++)
+    {
+        parents[i] = int(i) - 1;
+    }
+    Node* root = buildTreeFromParents(mats_.data(), parents.data(), mats_.size());
+
+    for (const ReduceOptions& options : allOptions())
+    {
+        EXPECT_EQ(sumTraces(mats_.data(), mats_.size()), sumTreeTraces(root, mats_.size(), options));
+        EXPECT_EQ(normMats(mats_.data(), mats_.size()), normTree(root, mats_.size(), options));
+        Mat33 expected = sumMats(mats_.data(), mats_.size());
+        Mat33 actual = sumTree(root, mats_.size(), options);
+        EXPECT_EQ(0, memcmp(&expected, &actual, sizeof(Mat33)));
+    }
+
+    destroyTree(root);
+}
@@ -0,0 +1,245 @@
+/// @file test/reference.hpp
+
+#ifndef SARCOS_TEST_REFERENCE_H
+#define SARCOS_TEST_REFERENCE_H
+
+#include "sarcos/math.hpp"
+#include "sarcos/prettyprinter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Reference implementations the optimized code is checked against
+ *
+ * Formatting is checked against iostreams, the way PrettyPrinter printed
+ * before FormatPolicy: std::fixed with the precision. A value whose fixed
+ * string fits within maxWidth (and is below sciThreshold) must print exactly
+ * like that; any other value is checked for the properties of the policy
+ * (see checkFormat()). The scalar math reference is math.hpp: dotProduct(),
+ * transposeMat(), copyMat() and multiplyMat().
+ *
+ * Shared by the differential tests and the fuzz targets.
+ */
+
+/**
+ * @brief settings of a PrettyPrinter
+ *
+ */
+struct ReferenceSettings
+{
+    int precision = 3;
+    int widthBuffer = 2;
+    FormatPolicy policy;
+};
+
+/**
+ * @brief one value in fixed point notation, as iostream prints it
+ *
+ */
+inline std::string referenceFixed(double val, int precision)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(precision) << val;
+    return out.str();
+}
+
+/**
+ * @brief one value in scientific notation, as iostream prints it
+ *
+ */
+inline std::string referenceScientific(double val, int precision)
+{
+    std::ostringstream out;
+    out << std::scientific << std::setprecision(precision) << val;
+    return out.str();
+}
+
+/**
+ * @brief check a value formatted by PrettyPrinter::format() against the policy
+ *
+ * - never wider than maxWidth
+ * - NaN and infinity: the token, right aligned, as wide as the longest token (cut to maxWidth)
+ * - fixed point as iostream prints it, whenever that fits and the value is below sciThreshold
+ * - otherwise scientific notation as iostream prints it, with as many decimal
+ *   places as fit up to the precision, or maxWidth overflow fill characters
+ *   if not even 0 decimal places fit
+ *
+ * @param val - value
+ * @param formatted - output of format()
+ * @param settings - precision and policy
+ * @return std::string - empty if the checks pass, otherwise what failed
+ */
+inline std::string checkFormat(double val, const std::string& formatted, const ReferenceSettings& settings)
+{
+    const FormatPolicy& policy = settings.policy;
+    const size_t maxWidth = policy.maxWidth;
+    if (formatted.size() > maxWidth)
+    {
+        return "wider than maxWidth " + std::to_string(maxWidth);
+    }
+
+    if (std::isnan(val) || std::isinf(val))
+    {
+        const std::string& token = std::isnan(val) ? policy.nanToken : (val > 0 ? policy.posInfToken : policy.negInfToken);
+        const size_t longest = std::max(policy.nanToken.size(), std::max(policy.posInfToken.size(), policy.negInfToken.size()));
+        if (formatted.size() != std::min(longest, maxWidth))
+        {
+            return "token not as wide as the longest token";
+        }
+        const size_t width = formatted.size();
+        const std::string expected = token.size() >= width ? token.substr(0, width) : std::string(width - token.size(), ' ') + token;
+        return formatted == expected ? "" : "expected the token \"" + expected + "\"";
+    }
+
+    const std::string fixed = referenceFixed(val, settings.precision);
+    if (std::fabs(val) < policy.sciThreshold && fixed.size() <= maxWidth)
+    {
+        return formatted == fixed ? "" : "expected iostream's \"" + fixed + "\"";
+    }
+
+    if (formatted == std::string(maxWidth, policy.overflowFill))
+    {
+        return referenceScientific(val, 0).size() > maxWidth ? "" : "overflow fill, but scientific notation fits";
+    }
+
+    // decimal places of the scientific notation
+    const size_t exponent = formatted.find('e');
+    const size_t point = formatted.find('.');
+    if (exponent == std::string::npos)
+    {
+        return "neither fixed nor scientific notation";
+    }
+    const int decimals = point == std::string::npos ? 0 : int(exponent - point - 1);
+    if (formatted != referenceScientific(val, decimals))
+    {
+        return "expected iostream's \"" + referenceScientific(val, decimals) + "\"";
+    }
+    const int precision = settings.precision < 0 ? 6 : settings.precision;
+    if (decimals > precision)
+    {
+        return "more decimal places than the precision";
+    }
+    if (decimals < precision && referenceScientific(val, decimals + 1).size() <= maxWidth)
+    {
+        return "dropped decimal places that fit";
+    }
+    return "";
+}
+
+/**
+ * @brief one line of three values, right aligned to the widths
+ *
+ */
+inline void referenceLine(std::ostream& out, const std::string* values, const int* widths)
+{
+    out << "[ ";
+    for (int k=0; k<3; k++)
+    {
+        out << std::right << std::setw(widths[k]) << values[k];
+    }
+    out << " ]\n";
+}
+
+/**
+ * @brief layout of PrettyPrinter::print(const Vec3&), given how each value formats
+ *
+ * @param vec - vector
+ * @param widthBuffer - spaces between values
+ * @param format - called as format(double), returning the formatted value
+ */
+template <typename Format>
+std::string referencePrint(const Vec3& vec, int widthBuffer, Format format)
+{
+    const std::string values[3] = {format(vec.x), format(vec.y), format(vec.z)};
+    int widths[3];
+    for (int k=0; k<3; k++)
+    {
+        widths[k] = int(values[k].size()) + (k > 0 ? widthBuffer : 0);
+    }
+
+    std::ostringstream out;
+    referenceLine(out, values, widths);
+    out << '\n';
+    return out.str();
+}
+
+/**
+ * @brief layout of PrettyPrinter::print(const Mat33&), each column as wide as its widest value
+ *
+ * @param mat - matrix
+ * @param widthBuffer - spaces between columns
+ * @param format - called as format(double), returning the formatted value
+ */
+template <typename Format>
+std::string referencePrint(const Mat33& mat, int widthBuffer, Format format)
+{
+    const Vec3* cols = mat.col;
+    const std::string rows[3][3] = {
+        {format(cols[0].x), format(cols[1].x), format(cols[2].x)},
+        {format(cols[0].y), format(cols[1].y), format(cols[2].y)},
+        {format(cols[0].z), format(cols[1].z), format(cols[2].z)},
+    };
+    int widths[3];
+    for (int c=0; c<3; c++)
+    {
+        size_t widest = std::max(rows[0][c].size(), std::max(rows[1][c].size(), rows[2][c].size()));
+        widths[c] = int(widest) + (c > 0 ? widthBuffer : 0);
+    }
+
+    std::ostringstream out;
+    for (const std::string* row : rows)
+    {
+        referenceLine(out, row, widths);
+    }
+    out << '\n';
+    return out.str();
+}
+
+/**
+ * @brief printer configured like the settings, writing to out
+ *
+ */
+inline void configurePrinter(PrettyPrinter& printer, const ReferenceSettings& settings, std::ostream& out)
+{
+    printer.setPrecision(settings.precision);
+    printer.setWidthBuffer(settings.widthBuffer);
+    printer.setFormatPolicy(settings.policy);
+    printer.setOutputStream(out);
+}
+
+/**
+ * @brief identical results: same bits, or both NaN (payloads may differ)
+ *
+ */
+inline bool sameResult(double a, double b)
+{
+    if (std::isnan(a) && std::isnan(b))
+    {
+        return true;
+    }
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/**
+ * @brief identical matrices, see sameResult(double, double)
+ *
+ */
+inline bool sameResult(const Mat33& a, const Mat33& b)
+{
+    const double* va = &a.col[0].x;
+    const double* vb = &b.col[0].x;
+    for (int k=0; k<9; k++)
+    {
+        if (!sameResult(va[k], vb[k]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // SARCOS_TEST_REFERENCE_H
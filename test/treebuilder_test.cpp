@@ -0,0 +1,209 @@
+/// @file src/sarcos/treebuilder_test.cpp
+
+#include <gtest/gtest.h>
+#include "sarcos/treebuilder.hpp"
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief matrix tagged with a value, to recognize nodes after the build
+ * 
+ * @param tag - value of every element
+ * @return Mat33 
+ */
+static Mat33 taggedMat(double tag)
+{
+    return {{{tag,tag,tag}, {tag,tag,tag}, {tag,tag,tag}}};
+}
+
+/**
+ * @brief Build a chain, the layout of main.cpp
+ * 
+ */
+TEST(TreeBuilderTest, chain)
+{
+    vector<Mat33> data = {taggedMat(1), taggedMat(2), taggedMat(3), taggedMat(4)};
+    vector<int> parents = {-1, 0, 1, 2};
+
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+    EXPECT_TRUE(validateTree(root, data.size()));
+
+    // same numChildren as the nodes of main.cpp
+    const Node* node = root;
+    for (unsigned int expected : {3u, 2u, 1u, 0u})
+    {
+        ASSERT_NE(nullptr, node);
+        EXPECT_EQ(expected, node->numChildren);
+        EXPECT_EQ(4.0 - expected, node->data.col[1].y);
+        node = node->children;
+    }
+    EXPECT_EQ(nullptr, node);
+
+    destroyTree(root);
+}
+
+/**
+ * @brief Build a branching tree from parent indices
+ * 
+ *        0
+ *      / | \
+ *     1  2  3
+ *    / \    |
+ *   4   5   6
+ */
+TEST(TreeBuilderTest, fromParents)
+{
+    vector<Mat33> data;
+    for (int i=0; i<7; i++)
+    {
+        data.push_back(taggedMat(i));
+    }
+    vector<int> parents = {-1, 0, 0, 0, 1, 1, 3};
+
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+    ASSERT_TRUE(validateTree(root, data.size()));
+
+    // preorder: 0 1 4 5 2 3 6
+    vector<double> preorder;
+    for (size_t i=0; i<data.size(); i++)
+    {
+        preorder.push_back(root[i].data.col[0].x);
+    }
+    EXPECT_EQ(vector<double>({0, 1, 4, 5, 2, 3, 6}), preorder);
+
+    // direct children of the root, skipping over sibling subtrees
+    vector<double> children;
+    for (Node* child = root->children; child <= root + root->numChildren; child += 1 + child->numChildren)
+    {
+        children.push_back(child->data.col[0].x);
+    }
+    EXPECT_EQ(vector<double>({1, 2, 3}), children);
+    EXPECT_EQ(6u, root->numChildren);
+    EXPECT_EQ(2u, root[1].numChildren);
+    EXPECT_EQ(nullptr, root[4].children);
+
+    destroyTree(root);
+}
+
+/**
+ * @brief Build the same tree from preorder children counts
+ * 
+ */
+TEST(TreeBuilderTest, fromChildCounts)
+{
+    // preorder 0 1 4 5 2 3 6
+    vector<Mat33> data = {taggedMat(0), taggedMat(1), taggedMat(4), taggedMat(5), taggedMat(2), taggedMat(3), taggedMat(6)};
+    vector<unsigned int> childCounts = {3, 2, 0, 0, 0, 1, 0};
+
+    Node* root = buildTreeFromChildCounts(data.data(), childCounts.data(), data.size());
+    ASSERT_TRUE(validateTree(root, data.size()));
+    EXPECT_EQ(6u, root->numChildren);
+    EXPECT_EQ(2u, root[1].numChildren);
+    EXPECT_EQ(1u, root[5].numChildren);
+    EXPECT_EQ(&root[6], root[5].children);
+    EXPECT_EQ(6.0, root[6].data.col[2].z);
+
+    destroyTree(root);
+}
+
+/**
+ * @brief Inconsistent inputs are rejected
+ * 
+ */
+TEST(TreeBuilderTest, invalidInput)
+{
+    vector<Mat33> data(3, taggedMat(0));
+
+    // no root, forward reference, second root
+    EXPECT_THROW(buildTreeFromParents(data.data(), vector<int>({0, 0, 1}).data(), 3), invalid_argument);
+    EXPECT_THROW(buildTreeFromParents(data.data(), vector<int>({-1, 2, 0}).data(), 3), invalid_argument);
+    EXPECT_THROW(buildTreeFromParents(data.data(), vector<int>({-1, -1, 0}).data(), 3), invalid_argument);
+    EXPECT_THROW(buildTreeFromParents(data.data(), vector<int>({-1}).data(), 0), invalid_argument);
+
+    // too many children, a forest of two trees
+    EXPECT_THROW(buildTreeFromChildCounts(data.data(), vector<unsigned int>({3, 0, 0}).data(), 3), invalid_argument);
+    EXPECT_THROW(buildTreeFromChildCounts(data.data(), vector<unsigned int>({1, 0, 0}).data(), 3), invalid_argument);
+}
+
+/**
+ * @brief Hand edited numChildren fail validation
+ * 
+ */
+TEST(TreeBuilderTest, validateTree)
+{
+    vector<Mat33> data(4, taggedMat(0));
+    vector<int> parents = {-1, 0, 0, 2};
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+    ASSERT_TRUE(validateTree(root, data.size()));
+
+    // wrong count of the allocation
+    EXPECT_FALSE(validateTree(root, 3));
+
+    // numChildren not matching the children subtrees
+    root[1].numChildren = 1;
+    root[1].children = &root[2];
+    EXPECT_FALSE(validateTree(root, data.size()));
+    root[1].numChildren = 0;
+    root[1].children = nullptr;
+    EXPECT_TRUE(validateTree(root, data.size()));
+
+    // leaf with a child pointer
+    root[3].children = &root[0];
+    EXPECT_FALSE(validateTree(root, data.size()));
+
+    destroyTree(root);
+}
+
+/**
+ * @brief checkTree() rejects a hand-linked chain, like the nodes of main.cpp
+ * 
+ */
+TEST(TreeBuilderTest, checkTree)
+{
+    Node node3 = {taggedMat(3), nullptr, 0};
+    Node node2 = {taggedMat(2), &node3, 1};
+    Node node1 = {taggedMat(1), &node2, 2};
+
+    // node1 + 1 is not node2: indexing the chain by position would read past node1
+    EXPECT_THROW(checkTree(&node1, 3), invalid_argument);
+    EXPECT_THROW(checkTree(&node3, 0), invalid_argument);
+    EXPECT_NO_THROW(checkTree(&node3, 1));
+
+    vector<Mat33> data(3, taggedMat(0));
+    vector<int> parents = {-1, 0, 1};
+    Node* root = buildTreeFromParents(data.data(), parents.data(), data.size());
+    EXPECT_NO_THROW(checkTree(root, data.size()));
+    EXPECT_THROW(checkTree(root, 2), invalid_argument);
+    destroyTree(root);
+}
+
+/**
+ * @brief Large trees are built and validated on multiple threads
+ * 
+ */
+TEST(TreeBuilderTest, largeTree)
+{
+    // complete binary tree of 2^18 - 1 nodes
+    const size_t count = (1 << 18) - 1;
+    vector<Mat33> data(count);
+    vector<int> parents(count);
+    for (size_t i=0; i<count; i++)
+    {
+        data[i] = taggedMat(i);
+        parents[i] = (i == 0) ? -1 : int((i - 1) / 2);
+    }
+
+    Node* root = buildTreeFromParents(data.data(), parents.data(), count, 4);
+    EXPECT_TRUE(validateTree(root, count, 4));
+    EXPECT_TRUE(validateTree(root, count, 1));
+    EXPECT_EQ(count - 1, root->numChildren);
+
+    // left spine: 0, 1, 3, 7, ...
+    EXPECT_EQ(1.0, root[1].data.col[0].x);
+    EXPECT_EQ(3.0, root[2].data.col[0].x);
+    EXPECT_EQ(count / 2 - 1, root[1].numChildren);
+
+    destroyTree(root);
+}